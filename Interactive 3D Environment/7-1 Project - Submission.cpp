@@ -7,6 +7,12 @@ Version: 1.0
 
 #include <iostream>         // cout, cerr
 #include <cstdlib>          // EXIT_FAILURE
+#include <cmath>            // tan
+#include <cstring>          // memcmp
+#include <chrono>           // steady_clock
+#include <string>           // string
+#include <vector>           // vector
+#include <thread>           // hardware_concurrency
 #include <GL/glew.h>        // GLEW library
 #include <GLFW/glfw3.h>     // GLFW library
 #define STB_IMAGE_IMPLEMENTATION
@@ -18,6 +24,16 @@ Version: 1.0
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "meshes.h" // Meshes class
+#include "renderqueue.h" // RenderQueue class
+#include "frustum.h" // Frustum culling
+#include "occlusion.h" // OcclusionBuffer class
+#include "occlusionqueries.h" // OcclusionQueries class
+#include "gpuculling.h" // GpuCulling class
+#include "staticbatches.h" // StaticBatches class
+#include "uniforms.h" // UniformTable class
+#include "frameblock.h" // FrameBlock struct
+#include "glstate.h" // GLState class
+#include "materialtextures.h" // MaterialTextures class
 #include "camera.h" // Camera class
 
 using namespace std; // Standard namespace
@@ -26,6 +42,10 @@ using namespace std; // Standard namespace
 #ifndef GLSL
 #define GLSL(Version, Source) "#version " #Version " core \n" #Source
 #endif
+/*Shader source Macro for pieces joined after a version line*/
+#ifndef GLSL_SOURCE
+#define GLSL_SOURCE(Source) #Source
+#endif
 
 // Unnamed namespace
 namespace
@@ -40,19 +60,102 @@ namespace
     GLFWwindow* gWindow = nullptr;
 
     Meshes meshes;
+    // Layout of the mesh vertices, VERTEX_FORMAT_PACKED halves the vertex fetch bandwidth
+    const VertexFormat MESH_VERTEX_FORMAT = VERTEX_FORMAT_FLOAT;
+    // Largest on-screen deviation, in pixels, allowed when picking a mesh detail level
+    const GLfloat LOD_PIXEL_ERROR = 1.0f;
 
-    // Texture id
-    GLuint gTextureIdBottomCylinderLiquid;
-    GLuint gTextureIdTopCylinderRibbed;
-    GLuint gTextureIdCone;
-    GLuint gTextureIdPlane;
-    GLuint gTextureIdSphere;
-    GLuint gTextureIdCubeCards;
-    GLuint gTextureIdCoaster;
+    // Materials of the scene, one per texture
+    enum MaterialId
+    {
+        MATERIAL_BOTTOM_CYLINDER_LIQUID,
+        MATERIAL_TOP_CYLINDER_RIBBED,
+        MATERIAL_CONE,
+        MATERIAL_PLANE,
+        MATERIAL_SPHERE,
+        MATERIAL_CUBE_CARDS,
+        MATERIAL_COASTER,
+        MATERIAL_COUNT
+    };
+    // Texture file of each material
+    const char* const MATERIAL_TEXTURES[MATERIAL_COUNT] =
+    {
+        "bottomcylinderliquid3.jpg",
+        "topcylinderribbed.jpg",
+        "cone.jpg",
+        "plane.jpg",
+        "tennisball.jpg",
+        "playingcards.png",
+        "coaster2.jpg"
+    };
+    Material gMaterials[MATERIAL_COUNT];
+    // Textures of every material, selected in the shader by material index
+    MaterialTextures gMaterialTextures;
+
+    // Scene description: mesh, material, scale, rotation, translation, texture tiling and occluder flag of every object
+    const SceneObject SCENE[] =
+    {
+        // Cylinder, rotated one full time
+        { &meshes.gCylinderMesh, MATERIAL_BOTTOM_CYLINDER_LIQUID, glm::vec3(0.85f, 2.5f, 0.85f), 3.1415f, glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-0.75f, 0.501f, -5.0f), glm::vec2(0.80f, 1.0f), false },
+        // Cylinder top, rotated one full time
+        { &meshes.gCylinderMesh, MATERIAL_TOP_CYLINDER_RIBBED, glm::vec3(0.85f, 0.75f, 0.85f), 3.1415f, glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-0.75f, 1.25f, -5.0f), glm::vec2(0.80f, 1.0f), false },
+        // Cone
+        { &meshes.gConeMesh, MATERIAL_CONE, glm::vec3(0.85f, 0.5f, 0.85f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-0.75f, 1.25f, -5.0f), glm::vec2(0.80f, 1.0f), false },
+        // Plane in the middle of the screen, rotated one full time
+        { &meshes.gPlaneMesh, MATERIAL_PLANE, glm::vec3(2.5f, 1.0f, 2.5f), 3.1415f, glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 3.0f, -3.0f), glm::vec2(1.0f, 1.2f), true },
+        // Sphere (tennis ball)
+        { &meshes.gSphereMesh, MATERIAL_SPHERE, glm::vec3(1.01f, 1.1f, 1.1f), 0.0f, glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(2.25f, -0.9f, -3.25f), glm::vec2(1.0f, 1.2f), false },
+        // Cube (playing cards), rotated a quarter turn
+        { &meshes.gCubeMesh, MATERIAL_CUBE_CARDS, glm::vec3(3.25f, 0.75f, 2.1f), 1.5707963f, glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(-3.25f, -1.615f, -1.75f), glm::vec2(1.0f, 1.0f), true },
+        // Hexagon (coaster)
+        { &meshes.gHexagonMesh, MATERIAL_COASTER, glm::vec3(0.4f, 0.6f, 0.4f), 0.0f, glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.5f, -1.95f, 1.0f), glm::vec2(1.0f, 1.0f), true }
+    };
+    // Draw packets built from the scene each frame
+    RenderQueue gRenderQueue;
+    // Last state change counts reported, printed again only when they change
+    GLuint gLastStateChangesUnsorted = 0;
+    GLuint gLastStateChangesSorted = 0;
+    // Last culled and occluded object counts reported
+    GLuint gLastCulled = 0;
+    GLuint gLastOccluded = 0;
+    // Software depth buffer the large scene objects are rasterized into each frame
+    OcclusionBuffer gOcclusion;
+    // GPU occlusion queries against the bounding boxes of the objects, off until switched on with G
+    OcclusionQueries gOcclusionQueries;
+    bool gOcclusionQueriesOn = false;
+    // Frames between reports of the query counters
+    const GLuint OCCLUSION_QUERY_REPORT_FRAMES = 300;
+    GLuint gOcclusionQueryFrames = 0;
+    // Culling and detail selection in compute passes, off until switched on with K
+    GpuCulling gGpuCulling;
+    bool gGpuCullingOn = false;
+    // Frames between reports of the objects GPU culling lets through, each report waits for the GPU
+    const GLuint GPU_CULL_REPORT_FRAMES = 300;
+    GLuint gGpuCullingFrames = 0;
+    // The scene baked into one merged batch per material, off until switched on with B
+    StaticBatches gStaticBatches;
+    bool gStaticBatchingOn = false;
+    // Last culled batch count reported
+    GLuint gLastBatchesCulled = 0;
     bool gIsFruitOn = true;
 
+    // Shadow of the GL state, drops calls that would not change it
+    GLState gGLState;
+
     // Shader program
     GLuint gProgramId;
+    // Active uniforms of the shader program
+    UniformTable gProgramUniforms;
+    // Depth only program drawing the proxy boxes of occlusion queries
+    GLuint gBoxProgramId;
+    UniformTable gBoxProgramUniforms;
+    // Compute programs of GPU culling: the culling pass and the depth pyramid reduction
+    GLuint gCullProgramId;
+    UniformTable gCullProgramUniforms;
+    GLuint gPyramidProgramId;
+    UniformTable gPyramidProgramUniforms;
+    // Uniform buffer holding the FrameBlock shared by every program
+    GLuint gFrameBlockId;
 
     // camera
     Camera gCamera(glm::vec3(0.0f, 1.5f, 10.0f));
@@ -66,6 +169,12 @@ namespace
 
     // Utilized for Perspective/Orthographic changes
     bool perspectiveOrtho = true;
+    // Submit the scene with multi-draw indirect instead of one draw call per object
+    bool gIndirectDraws = true;
+    // Collapse packets of the same mesh, detail level and material into instanced draws, ahead of the indirect path
+    bool gInstancedDraws = false;
+    // Prepare the frame's draws on worker threads and replay them here, ahead of every per-packet path
+    bool gRecordOnThreads = false;
 
     // Light color, position and scale for overhead light (yellowish-white color)
     glm::vec3 gLightColor(0.90196f, 0.84313f, 0.76863f);
@@ -90,59 +199,414 @@ void UMousePositionCallback(GLFWwindow* window, double xpos, double ypos);
 void UMouseScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
 void UMouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 bool UCreateTexture(const char* filename, GLuint& textureId);
+void UCreatePlaceholderTexture(GLuint& textureId);
 void UDestroyTexture(GLuint textureId);
 void URender();
-bool UCreateShaderProgram(const char* vtxShaderSource, const char* fragShaderSource, GLuint& programId);
+void URenderGpuCulled(const RenderView& renderView, const glm::mat4& viewProjection);
+FrameBlock UBuildFrameBlock(const glm::mat4& view, const glm::mat4& projection);
+bool URunSelfTests(const string& fragmentSource);
+bool UBenchmarkMeshCache();
+void UBenchmarkSubmission();
+bool UBenchmarkInstancing();
+bool UBenchmarkStaticBatching();
+bool UTestCommandRecording();
+void UBenchmarkNormalMatrix(const string& fragmentSource);
+bool UTestOcclusionQueries();
+bool UTestGpuCulling();
+bool UCreateShaderProgram(const char* vtxShaderSource, const char* fragShaderSource, GLuint& programId, UniformTable& uniforms);
+bool UCreateComputeProgram(const char* computeShaderSource, GLuint& programId, UniformTable& uniforms);
 void UDestroyShaderProgram(GLuint programId);
 
 
 // Vertex Shader Source Code
 const GLchar* vertexShaderSource = GLSL(440,
     layout(location = 0) in vec3 position; // Vertex data from Vertex Attrib Pointer 0
-layout(location = 1) in vec3 normal; // Normal data from Vertex Attrib Pointer 1
+layout(location = 1) in vec3 normal; // Normal data from Vertex Attrib Pointer 1 (octahedral encoded in xy for packed vertices)
 layout(location = 2) in vec2 textureCoordinate; // Texture data from Vertex Attrib Pointer 2
+layout(location = 3) in uint drawIndex; // Draw of an indirect submission, instanced attribute read at the command's baseInstance
+// Per-instance data of instanced submissions, laid out like InstanceAttributes in renderqueue.h
+layout(location = 4) in mat4 instanceModel;
+layout(location = 8) in mat3 instanceNormalMatrix;
+layout(location = 11) in vec2 instanceUvScale;
+layout(location = 12) in uint instanceMaterial;
 
 out vec3 vertexNormal; // For outgoing normals to fragment shader
 out vec3 vertexFragmentPos; // For outgoing color / pixels to fragment shader
 out vec2 vertexTextureCoordinate; // variable to transfer texture data to the fragment shader
+flat out vec2 vertexUvScale; // Texture tiling of the draw
+flat out uint vertexMaterial; // Material index of the draw
 
 //Global variables for the  transform matrices
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat3 normalMatrix; // Inverse transpose of the model's upper 3x3, worked out once per object on the CPU
+// Per-frame camera and lighting data, laid out like FrameBlock in frameblock.h
+layout(std140, binding = 0) uniform FrameBlock
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosition;
+    vec3 lightColor;
+    vec3 lightPos;
+    vec3 windowLightColor;
+    vec3 windowLightPos;
+};
+
+// Packed vertex decoding
+uniform bool packedVertices;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+uniform vec2 uvScale;
+uniform int materialId;
+
+// Per-draw data of indirect submissions, laid out like DrawRecord in renderqueue.h
+struct DrawRecord
+{
+    mat4 model;
+    mat3 normalMatrix;
+    vec4 positionOffset;
+    vec4 positionScale;
+    vec2 uvScale;
+    uint material;
+};
+layout(std430, binding = 0) readonly buffer DrawRecords
+{
+    DrawRecord drawRecords[];
+};
+uniform bool useDrawRecords; // Read model, dequantization and tiling from drawRecords instead of the uniforms
+uniform bool useInstances; // Read model, normal matrix, tiling and material from the instance attributes instead of the uniforms
+
+// Unfolds an octahedral encoded normal
+vec3 octDecode(vec2 encoded)
+{
+    vec3 v = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    if (v.z < 0.0)
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(v);
+}
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(position, 1.0f); // transforms vertices to clip coordinates
+    mat4 drawModel = model;
+    mat3 drawNormalMatrix = normalMatrix;
+    vec3 drawOffset = positionOffset;
+    vec3 drawScale = positionScale;
+    vertexUvScale = uvScale;
+    vertexMaterial = uint(materialId);
+    if (useDrawRecords)
+    {
+        drawModel = drawRecords[drawIndex].model;
+        drawNormalMatrix = drawRecords[drawIndex].normalMatrix;
+        drawOffset = drawRecords[drawIndex].positionOffset.xyz;
+        drawScale = drawRecords[drawIndex].positionScale.xyz;
+        vertexUvScale = drawRecords[drawIndex].uvScale;
+        vertexMaterial = drawRecords[drawIndex].material;
+    }
+    else if (useInstances)
+    {
+        drawModel = instanceModel;
+        drawNormalMatrix = instanceNormalMatrix;
+        vertexUvScale = instanceUvScale;
+        vertexMaterial = instanceMaterial;
+    }
 
-    vertexFragmentPos = vec3(model * vec4(position, 1.0f)); // Gets fragment / pixel position in world space only (exclude view and projection)
+    vec3 localPosition = drawOffset + position * drawScale; // identity for float vertices
+    vec3 localNormal = packedVertices ? octDecode(normal.xy) : normal;
 
-    vertexNormal = mat3(transpose(inverse(model))) * normal; // get normal vectors in world space only and exclude normal translation properties
+    gl_Position = projection * view * drawModel * vec4(localPosition, 1.0f); // transforms vertices to clip coordinates
+
+    vertexFragmentPos = vec3(drawModel * vec4(localPosition, 1.0f)); // Gets fragment / pixel position in world space only (exclude view and projection)
+
+    vertexNormal = drawNormalMatrix * localNormal; // get normal vectors in world space only and exclude normal translation properties
 
     vertexTextureCoordinate = textureCoordinate; // references incoming texture data
 }
 );
 
 
-// Fragment Shader Source Code
-const GLchar* fragmentShaderSource = GLSL(440,
+// Occlusion query box Vertex Shader Source Code
+const GLchar* boxVertexShaderSource = GLSL(440,
+    layout(location = 0) in vec3 position; // Corner of the unit cube
+
+// Per-frame camera and lighting data, laid out like FrameBlock in frameblock.h
+layout(std140, binding = 0) uniform FrameBlock
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosition;
+    vec3 lightColor;
+    vec3 lightPos;
+    vec3 windowLightColor;
+    vec3 windowLightPos;
+};
+
+uniform mat4 boxTransform; // Maps the unit cube onto the bounding box in world space
+
+void main()
+{
+    gl_Position = projection * view * boxTransform * vec4(position, 1.0f);
+}
+);
+
+// Occlusion query box Fragment Shader Source Code, color writes are off and only depth is tested
+const GLchar* boxFragmentShaderSource = GLSL(440,
+void main()
+{
+}
+);
+
+
+// GPU culling Compute Shader Source Code, one object per invocation
+const GLchar* cullComputeShaderSource = GLSL(440,
+    layout(local_size_x = 64) in; // GPU_CULL_GROUP_SIZE
+
+// Inputs and outputs, laid out like GpuCullObject, GpuCullMesh, CullBlock and DrawElementsIndirectCommand
+struct CullObject
+{
+    vec4 sphere; // Center, radius in w
+    vec4 boxCenter;
+    vec4 boxExtent; // Half size, largest axis scale of the model in w
+    uint mesh;
+    uint group;
+    uint padding0;
+    uint padding1;
+};
+struct CullLod
+{
+    uint firstIndex;
+    uint nIndices;
+    float error;
+    uint padding;
+};
+struct CullMesh
+{
+    int baseVertex;
+    uint nLods;
+    uint padding0;
+    uint padding1;
+    CullLod lods[6]; // Meshes::MESH_MAX_LODS
+};
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout(std140, binding = 1) uniform CullBlock
+{
+    vec4 frustumPlanes[6];
+    mat4 depthViewProjection; // View projection the depth pyramid was rendered with
+    vec4 cameraPosition;
+    float unitsPerPixel;
+    float pixelError;
+    uint perspective;
+    uint useDepthPyramid;
+    uint nObjects;
+    uint depthWidth;
+    uint depthHeight;
+    int pyramidLevels;
+};
+layout(std430, binding = 2) readonly buffer CullObjects
+{
+    CullObject cullObjects[];
+};
+layout(std430, binding = 3) readonly buffer CullMeshes
+{
+    CullMesh cullMeshes[];
+};
+layout(std430, binding = 4) readonly buffer CullGroups
+{
+    uint groupFirstCommand[];
+};
+layout(std430, binding = 5) writeonly buffer DrawCommands
+{
+    DrawCommand drawCommands[];
+};
+layout(std430, binding = 6) buffer DrawCounts
+{
+    uint drawCounts[];
+};
+
+uniform sampler2D depthPyramid; // Max depth of 2 x 2 texels per level, level 0 at half the depth buffer size
+
+// Same sphere and box tests as UIsVisible in frustum.cpp
+bool insideFrustum(CullObject object)
+{
+    for (int p = 0; p < 6; ++p)
+    {
+        vec4 plane = frustumPlanes[p];
+        if (dot(plane.xyz, object.sphere.xyz) + plane.w < -object.sphere.w)
+            return false;
+        if (dot(plane.xyz, object.boxCenter.xyz) + plane.w < -dot(abs(plane.xyz), object.boxExtent.xyz))
+            return false;
+    }
+    return true;
+}
+
+// False when the depth pyramid holds something nearer than the box over every pixel the box covers
+bool unoccluded(CullObject object)
+{
+    vec2 lower = vec2(1e30);
+    vec2 upper = vec2(-1e30);
+    float nearest = 1.0;
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        vec3 direction = vec3((corner & 1) != 0 ? 1.0 : -1.0, (corner & 2) != 0 ? 1.0 : -1.0, (corner & 4) != 0 ? 1.0 : -1.0);
+        vec4 clip = depthViewProjection * vec4(object.boxCenter.xyz + object.boxExtent.xyz * direction, 1.0);
+        // Boxes reaching behind the camera cannot be placed on screen
+        if (clip.w < 1e-4)
+            return true;
+
+        vec3 ndc = clip.xyz / clip.w;
+        vec2 screen = (ndc.xy * 0.5 + 0.5) * vec2(depthWidth, depthHeight);
+        lower = min(lower, screen);
+        upper = max(upper, screen);
+        nearest = min(nearest, ndc.z * 0.5 + 0.5);
+    }
+
+    // Every pixel the rectangle touches; off screen is left to the frustum test
+    vec2 lastPixel = vec2(depthWidth, depthHeight) - 1.0;
+    ivec2 minPixel = ivec2(clamp(floor(lower), vec2(0.0), lastPixel + 1.0));
+    ivec2 maxPixel = ivec2(clamp(floor(upper), vec2(-1.0), lastPixel));
+    if (any(greaterThan(minPixel, maxPixel)))
+        return true;
+
+    // Coarsest level first where the rectangle spans at most 2 x 2 texels; pixel p lies in texel p >> (level + 1)
+    int level = 0;
+    ivec2 first = min(minPixel >> 1, textureSize(depthPyramid, 0) - 1);
+    ivec2 last = min(maxPixel >> 1, textureSize(depthPyramid, 0) - 1);
+    while (level + 1 < pyramidLevels && any(greaterThan(last - first, ivec2(1))))
+    {
+        ++level;
+        first = min(minPixel >> (level + 1), textureSize(depthPyramid, level) - 1);
+        last = min(maxPixel >> (level + 1), textureSize(depthPyramid, level) - 1);
+    }
+
+    float farthest = 0.0;
+    for (int y = first.y; y <= last.y; ++y)
+    {
+        for (int x = first.x; x <= last.x; ++x)
+            farthest = max(farthest, texelFetch(depthPyramid, ivec2(x, y), level).r);
+    }
+    return nearest <= farthest;
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= nObjects)
+        return;
+
+    CullObject object = cullObjects[i];
+    if (!insideFrustum(object))
+        return;
+    if (useDepthPyramid != 0u && !unoccluded(object))
+        return;
+
+    // Detail level with the arithmetic of RenderQueue::BuildPackets and Meshes::SelectLod
+    float distance = max(length(object.sphere.xyz - cameraPosition.xyz) - object.sphere.w, 0.0);
+    float pixelUnits = unitsPerPixel;
+    if (perspective != 0u)
+        pixelUnits *= max(distance, 0.1);
+    float maxError = pixelError * pixelUnits;
+
+    uint lod = 0u;
+    while (lod + 1u < cullMeshes[object.mesh].nLods && cullMeshes[object.mesh].lods[lod + 1u].error * object.boxExtent.w <= maxError)
+        ++lod;
+
+    // Packed at the front of the group's range
+    uint command = groupFirstCommand[object.group] + atomicAdd(drawCounts[object.group], 1u);
+    CullLod detail = cullMeshes[object.mesh].lods[lod];
+    drawCommands[command] = DrawCommand(detail.nIndices, 1u, detail.firstIndex, cullMeshes[object.mesh].baseVertex, i);
+}
+);
+
+// Depth pyramid Compute Shader Source Code, one texel of the level being built per invocation
+const GLchar* pyramidComputeShaderSource = GLSL(440,
+    layout(local_size_x = 8, local_size_y = 8) in; // GPU_PYRAMID_GROUP_SIZE
+
+uniform sampler2D source; // Depth copy for level 0, the pyramid itself for the levels after
+uniform int sourceLevel;
+layout(r32f, binding = 0) writeonly uniform image2D destination;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(destination);
+    if (any(greaterThanEqual(texel, size)))
+        return;
+
+    // Texels in the last row or column also cover the odd one out of the source
+    ivec2 sourceSize = textureSize(source, sourceLevel);
+    ivec2 first = texel * 2;
+    ivec2 last = ivec2(texel.x == size.x - 1 ? sourceSize.x - 1 : first.x + 1, texel.y == size.y - 1 ? sourceSize.y - 1 : first.y + 1);
+    last = min(last, sourceSize - 1);
+
+    float farthest = 0.0;
+    for (int y = first.y; y <= last.y; ++y)
+    {
+        for (int x = first.x; x <= last.x; ++x)
+            farthest = max(farthest, texelFetch(source, ivec2(x, y), sourceLevel).r);
+    }
+    imageStore(destination, texel, vec4(farthest));
+}
+);
+
+
+// Fragment shader first lines, bindless handles need the extension enabled
+const GLchar* fragmentShaderHeader = "#version 440 core \n";
+const GLchar* fragmentShaderBindlessHeader = "#version 440 core \n#extension GL_ARB_bindless_texture : require \n";
+
+// Material texture lookup through the texture array
+const GLchar* textureArraySamplingSource = GLSL_SOURCE(
+uniform sampler2DArray uMaterialTextures; // One layer per material
+
+vec4 sampleMaterial(uint material, vec2 uv)
+{
+    return texture(uMaterialTextures, vec3(uv, float(material)));
+}
+);
+
+// Material texture lookup through bindless handles
+const GLchar* bindlessSamplingSource = GLSL_SOURCE(
+layout(std430, binding = 1) readonly buffer MaterialHandles
+{
+    uvec2 materialHandles[]; // Texture handle of each material
+};
+
+vec4 sampleMaterial(uint material, vec2 uv)
+{
+    return texture(sampler2D(materialHandles[material]), uv);
+}
+);
+
+// Fragment Shader Source Code, follows the header and one of the sampling sources
+const GLchar* fragmentShaderSource = GLSL_SOURCE(
     in vec3 vertexNormal; // For incoming normals
 in vec3 vertexFragmentPos; // For incoming fragment position
 in vec2 vertexTextureCoordinate; // Variable to hold incoming texture data from vertex shader
+flat in vec2 vertexUvScale; // Texture tiling of the draw
+flat in uint vertexMaterial; // Material index of the draw
 
 out vec4 fragmentColor;
 
-uniform vec3 lightColor; // Uniform variables for light color
-uniform vec3 lightPos; // Uniform variables for light position
-uniform vec3 windowLightColor; // Uniform variables for window light color
-uniform vec3 windowLightPos; // Uniform variables for window light position
-
-uniform vec3 viewPosition; // Uniform variables for camera/view position
+// Per-frame camera and lighting data, laid out like FrameBlock in frameblock.h
+layout(std140, binding = 0) uniform FrameBlock
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosition;
+    vec3 lightColor;
+    vec3 lightPos;
+    vec3 windowLightColor;
+    vec3 windowLightPos;
+};
 
-uniform sampler2D uTextureBase;
-uniform sampler2D uTextureExtra;
-uniform vec2 uvScale;
 uniform bool multipleTextures;
+uniform int extraMaterial; // Material drawn over the base wherever its texture is opaque
 
 void main()
 {
@@ -183,10 +647,10 @@ void main()
     specular *= attenuation;
 
     // Texture holds the color to be used for all three components
-    vec4 textureColor = texture(uTextureBase, vertexTextureCoordinate * uvScale);
+    vec4 textureColor = sampleMaterial(vertexMaterial, vertexTextureCoordinate * vertexUvScale);
     if (multipleTextures)
     {
-        vec4 extraTexture = texture(uTextureExtra, vertexTextureCoordinate * uvScale);
+        vec4 extraTexture = sampleMaterial(uint(extraMaterial), vertexTextureCoordinate * vertexUvScale);
         if (extraTexture.a != 0.0)
             textureColor = extraTexture;
     }
@@ -221,73 +685,98 @@ void flipImageVertically(unsigned char* image, int width, int height, int channe
 
 int main(int argc, char* argv[])
 {
+    // Benchmarks and self-tests run in place of the render loop when asked for
+    bool selfTest = false;
+    for (int i = 1; i < argc; ++i)
+        selfTest = selfTest || strcmp(argv[i], "--self-test") == 0;
+
     if (!UInitialize(argc, argv, &gWindow))
         return EXIT_FAILURE;
 
     // Create the mesh
-    meshes.CreateMeshes();
+    meshes.CreateMeshes(MESH_VERTEX_FORMAT);
+
+    // Materials pick their texture by index, through bindless handles where the driver has them
+    const bool bindlessTextures = GLEW_ARB_bindless_texture != 0;
+    const string fragmentSource = string(bindlessTextures ? fragmentShaderBindlessHeader : fragmentShaderHeader)
+        + (bindlessTextures ? bindlessSamplingSource : textureArraySamplingSource) + "\n" + fragmentShaderSource;
 
     // Verify the shader program can be created
-    if (!UCreateShaderProgram(vertexShaderSource, fragmentShaderSource, gProgramId))
+    if (!UCreateShaderProgram(vertexShaderSource, fragmentSource.c_str(), gProgramId, gProgramUniforms))
         return EXIT_FAILURE;
 
-    //--------------------------------------------------
-    // Load textures
-    const char* texFilename = "bottomcylinderliquid3.jpg";
-    if (!UCreateTexture(texFilename, gTextureIdBottomCylinderLiquid))
-    {
-        cout << "Failed to load texture " << texFilename << endl;
+    // Proxy boxes of the occlusion queries
+    if (!UCreateShaderProgram(boxVertexShaderSource, boxFragmentShaderSource, gBoxProgramId, gBoxProgramUniforms))
         return EXIT_FAILURE;
-    }
-    texFilename = "topcylinderribbed.jpg";
-    if (!UCreateTexture(texFilename, gTextureIdTopCylinderRibbed))
-    {
-        cout << "Failed to load texture " << texFilename << endl;
-        return EXIT_FAILURE;
-    }
-    texFilename = "cone.jpg";
-    if (!UCreateTexture(texFilename, gTextureIdCone))
-    {
-        cout << "Failed to load texture " << texFilename << endl;
+
+    // Culling and depth pyramid passes of GPU culling
+    if (!UCreateComputeProgram(cullComputeShaderSource, gCullProgramId, gCullProgramUniforms)
+        || !UCreateComputeProgram(pyramidComputeShaderSource, gPyramidProgramId, gPyramidProgramUniforms))
         return EXIT_FAILURE;
-    }
-    texFilename = "plane.jpg";
-    if (!UCreateTexture(texFilename, gTextureIdPlane))
-    {
-        cout << "Failed to load texture " << texFilename << endl;
+
+    // Camera and lighting data shared by every program
+    if (!UCreateFrameBlock(gFrameBlockId))
         return EXIT_FAILURE;
-    }
-    texFilename = "tennisball.jpg";
-    if (!UCreateTexture(texFilename, gTextureIdSphere))
+
+    //--------------------------------------------------
+    // Load textures
+    for (GLuint m = 0; m < MATERIAL_COUNT; ++m)
     {
-        cout << "Failed to load texture " << texFilename << endl;
-        return EXIT_FAILURE;
+        if (!UCreateTexture(MATERIAL_TEXTURES[m], gMaterials[m].textureId))
+        {
+            // A missing image leaves its material checkered instead of stopping the program
+            cout << "ERROR: Failed to load texture " << MATERIAL_TEXTURES[m] << ", using a placeholder" << endl;
+            UCreatePlaceholderTexture(gMaterials[m].textureId);
+        }
+        // Every material is opaque and lit by the same shader
+        gMaterials[m].pass = RENDER_PASS_OPAQUE;
+        gMaterials[m].program = &gProgramUniforms;
+        gMaterials[m].uniforms = UFindDrawUniforms(gProgramUniforms);
     }
-    texFilename = "playingcards.png";
-    if (!UCreateTexture(texFilename, gTextureIdCubeCards))
-    {
-        cout << "Failed to load texture " << texFilename << endl;
+
+
+    // Put every material texture behind one binding
+    GLuint sourceTextures[MATERIAL_COUNT];
+    for (GLuint m = 0; m < MATERIAL_COUNT; ++m)
+        sourceTextures[m] = gMaterials[m].textureId;
+    if (!gMaterialTextures.CreateMaterialTextures(sourceTextures, MATERIAL_COUNT, bindlessTextures))
         return EXIT_FAILURE;
-    }
-    texFilename = "coaster2.jpg";
-    if (!UCreateTexture(texFilename, gTextureIdCoaster))
+    if (!bindlessTextures)
     {
-        cout << "Failed to load texture " << texFilename << endl;
-        return EXIT_FAILURE;
+        // The array holds copies, the sources are no longer needed
+        for (GLuint m = 0; m < MATERIAL_COUNT; ++m)
+        {
+            UDestroyTexture(gMaterials[m].textureId);
+            gMaterials[m].textureId = 0;
+        }
     }
+
+    // Compile the scene description once, the objects never move
+    gRenderQueue.SetScene(SCENE, sizeof(SCENE) / sizeof(SCENE[0]));
+    gRenderQueue.CreateIndirectBuffers(meshes);
+    gRenderQueue.CreateInstanceBuffers(meshes);
+    gRenderQueue.CreateCommandBuffers(thread::hardware_concurrency());
+    gStaticBatches.CreateStaticBatches(meshes, gRenderQueue.gObjects);
+    gOcclusion.CreateOcclusionBuffer(thread::hardware_concurrency());
+    gOcclusionQueries.CreateOcclusionQueries((GLuint)gRenderQueue.gObjects.size(), &gBoxProgramUniforms);
+    gGpuCulling.CreateGpuCulling(&gCullProgramUniforms, &gPyramidProgramUniforms);
+    gRenderQueue.UploadGpuScene(meshes, gMaterials, gGpuCulling);
     //--------------------------------------------------
 
-    glUseProgram(gProgramId);
-    // We set the texture as texture unit 0
-    glUniform1i(glGetUniformLocation(gProgramId, "uTextureBase"), 0);
-    // We set the texture as texture unit 1
-    glUniform1i(glGetUniformLocation(gProgramId, "uTextureExtra"), 1);
+    // We set the texture array as texture unit 0
+    gProgramUniforms.Set(gProgramUniforms.Find("uMaterialTextures"), 0);
+    // Tells the vertex shader how to decode the vertex format of the meshes
+    gProgramUniforms.Set(gProgramUniforms.Find("packedVertices"), (GLint)(meshes.gVertexFormat == VERTEX_FORMAT_PACKED));
+
+    bool selfTestsPassed = true;
+    if (selfTest)
+        selfTestsPassed = URunSelfTests(fragmentSource);
 
     // Sets the background color of the window to black
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    gGLState.ClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
-    // render loop until exit key is used
-    while (!glfwWindowShouldClose(gWindow))
+    // render loop until exit key is used, or not at all after the self-tests
+    while (!selfTest && !glfwWindowShouldClose(gWindow))
     {
         // per-frame timing
         // --------------------
@@ -305,23 +794,32 @@ int main(int argc, char* argv[])
         glfwPollEvents();
     }
 
+    cout << "INFO: GL state calls: " << gGLState.gIssued << " issued, " << gGLState.gFiltered << " filtered as redundant" << endl;
+
     // Release mesh data
     meshes.DestroyMeshes();
+    gRenderQueue.DestroyIndirectBuffers();
+    gRenderQueue.DestroyInstanceBuffers();
+    gRenderQueue.DestroyCommandBuffers();
+    gStaticBatches.DestroyStaticBatches();
+    gOcclusion.DestroyOcclusionBuffer();
+    gOcclusionQueries.DestroyOcclusionQueries();
+    gGpuCulling.DestroyGpuCulling();
 
     // Release texture
-    UDestroyTexture(gTextureIdBottomCylinderLiquid);
-    UDestroyTexture(gTextureIdTopCylinderRibbed);
-    UDestroyTexture(gTextureIdCone);
-    UDestroyTexture(gTextureIdPlane);
-    UDestroyTexture(gTextureIdSphere);
-    UDestroyTexture(gTextureIdCubeCards);
-    UDestroyTexture(gTextureIdCoaster);
+    gMaterialTextures.DestroyMaterialTextures();
+    for (GLuint m = 0; m < MATERIAL_COUNT; ++m)
+        UDestroyTexture(gMaterials[m].textureId);
 
     // Release shader program resources
     UDestroyShaderProgram(gProgramId);
+    UDestroyShaderProgram(gBoxProgramId);
+    UDestroyShaderProgram(gCullProgramId);
+    UDestroyShaderProgram(gPyramidProgramId);
+    UDestroyFrameBlock(gFrameBlockId);
 
     // Terminates the program
-    exit(EXIT_SUCCESS);
+    exit(selfTestsPassed ? EXIT_SUCCESS : EXIT_FAILURE);
 }
 
 
@@ -406,6 +904,42 @@ void UProcessInput(GLFWwindow* window)
         // change to orthographic
         perspectiveOrtho = false;
 
+    // key to change between indirect and per-object submission - I / U
+    if (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS)
+        gIndirectDraws = true;
+    if (glfwGetKey(window, GLFW_KEY_U) == GLFW_PRESS)
+        gIndirectDraws = false;
+
+    // key to collapse repeated draws into instanced draws and back - Y / T
+    if (glfwGetKey(window, GLFW_KEY_Y) == GLFW_PRESS)
+        gInstancedDraws = true;
+    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS)
+        gInstancedDraws = false;
+
+    // key to draw the merged static batches instead of the objects and back - B / N
+    if (glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS)
+        gStaticBatchingOn = true;
+    if (glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS)
+        gStaticBatchingOn = false;
+
+    // key to record the frame's draws on worker threads and back - R / V
+    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS)
+        gRecordOnThreads = true;
+    if (glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS)
+        gRecordOnThreads = false;
+
+    // key to switch GPU occlusion queries on and off - G / F
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS)
+        gOcclusionQueriesOn = true;
+    if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS)
+        gOcclusionQueriesOn = false;
+
+    // key to move culling and detail selection to the GPU and back - K / L
+    if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS)
+        gGpuCullingOn = true;
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS)
+        gGpuCullingOn = false;
+
     if (glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS && !gIsFruitOn)
         gIsFruitOn = true;
     else if (glfwGetKey(window, GLFW_KEY_J) == GLFW_PRESS && gIsFruitOn)
@@ -492,21 +1026,14 @@ void UMouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 // Functioned called to render frames
 void URender()
 {
-    glm::mat4 scale;
-    glm::mat4 rotation;
-    glm::mat4 translation;
-    glm::mat4 model;
     glm::mat4 view;
     glm::mat4 projection;
-    GLint modelLoc;
-    GLint viewLoc;
-    GLint projLoc;
 
     // Enable z-depth
-    glEnable(GL_DEPTH_TEST);
+    gGLState.Enable(GL_DEPTH_TEST);
 
     // Clear the frame and z buffers
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    gGLState.ClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     // Obtain the camera matrix
@@ -521,237 +1048,1041 @@ void URender()
         projection = glm::ortho(-5.0f, 5.0f, -5.0f, 5.0f, 0.1f, 100.0f);
     }
 
-    // Set the shader to be used
-    glUseProgram(gProgramId);
+    // Pass transform, light, and camera data to every shader program with one buffer write
+    const glm::vec3 cameraPosition = gCamera.Position;
+    UUpdateFrameBlock(gFrameBlockId, UBuildFrameBlock(view, projection));
+
+    // Every draw samples its material from the same texture binding
+    gMaterialTextures.BindMaterialTextures(gGLState);
+
+    // Pick the detail level and sort key of every object for this view
+    RenderView renderView;
+    renderView.cameraPosition = cameraPosition;
+    // Cull against the volume of the projection in use, perspective or the fixed orthographic box
+    renderView.frustum = UExtractFrustum(projection * view);
+    renderView.occlusion = nullptr;
+    renderView.perspective = perspectiveOrtho;
+    renderView.pixelError = LOD_PIXEL_ERROR;
+    if (perspectiveOrtho == true)
+        renderView.unitsPerPixel = 2.0f * std::tan(glm::radians(gCamera.Zoom) * 0.5f) / WINDOW_HEIGHT;
+    else
+        // The orthographic projection spans 10 units vertically
+        renderView.unitsPerPixel = 10.0f / WINDOW_HEIGHT;
+
+    if (gGpuCullingOn)
+    {
+        URenderGpuCulled(renderView, projection * view);
+        glfwSwapBuffers(gWindow);
+        return;
+    }
 
-    // Retrieves and passes transform matrices to the Shader program
-    modelLoc = glGetUniformLocation(gProgramId, "model");
-    viewLoc = glGetUniformLocation(gProgramId, "view");
-    projLoc = glGetUniformLocation(gProgramId, "projection");
+    // One draw per material, culled per batch; no packets, detail levels or occlusion culling
+    if (gStaticBatchingOn)
+    {
+        gStaticBatches.Submit(gMaterials, gGLState, renderView.frustum);
+        if (gStaticBatches.gCulled != gLastBatchesCulled)
+        {
+            cout << "INFO: Frustum culling skipped " << gStaticBatches.gCulled << " of " << gStaticBatches.gBatches.size() << " static batches" << endl;
+            gLastBatchesCulled = gStaticBatches.gCulled;
+        }
+        glfwSwapBuffers(gWindow);
+        return;
+    }
 
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+    // Objects behind the occluders, as the CPU rasterizer sees them
+    gRenderQueue.RasterizeOccluders(meshes, projection * view, gOcclusion);
+    renderView.occlusion = &gOcclusion;
+    if (gRecordOnThreads)
+        // Culling, detail levels, sort keys and draw records on worker threads, replayed below
+        gRenderQueue.RecordCommands(meshes, gMaterials, renderView);
+    else
+        gRenderQueue.BuildPackets(meshes, gMaterials, renderView);
 
-    // Reference matrix uniforms from the shader program for the cub color, light color, light position, and camera position
-    GLint lightColorLoc = glGetUniformLocation(gProgramId, "lightColor");
-    GLint lightPositionLoc = glGetUniformLocation(gProgramId, "lightPos");
-    GLint windowLightColorLoc = glGetUniformLocation(gProgramId, "windowLightColor");
-    GLint windowLightPositionLoc = glGetUniformLocation(gProgramId, "windowLightPos");
-    GLint viewPositionLoc = glGetUniformLocation(gProgramId, "viewPosition");
+    if (gRenderQueue.gCulled != gLastCulled)
+    {
+        cout << "INFO: Frustum culling skipped " << gRenderQueue.gCulled << " of " << gRenderQueue.gObjects.size() << " objects" << endl;
+        gLastCulled = gRenderQueue.gCulled;
+    }
+    if (gRenderQueue.gOccluded != gLastOccluded)
+    {
+        GLuint inFrustum = (GLuint)gRenderQueue.gObjects.size() - gRenderQueue.gCulled;
+        cout << "INFO: Occlusion culling hid " << gRenderQueue.gOccluded << " of " << inFrustum << " objects in the frustum, "
+            << 100.0f * (inFrustum - gRenderQueue.gOccluded) / max(inFrustum, 1u) << "% visible" << endl;
+        gLastOccluded = gRenderQueue.gOccluded;
+    }
 
-    // Pass color, light, and camera data to the shader program's corresponding uniforms
-    glUniform3f(lightColorLoc, gLightColor.r, gLightColor.g, gLightColor.b);
-    glUniform3f(lightPositionLoc, gLightPosition.x, gLightPosition.y, gLightPosition.z);
-    glUniform3f(windowLightColorLoc, gWindowLightColor.r, gWindowLightColor.g, gWindowLightColor.b);
-    glUniform3f(windowLightPositionLoc, gWindowLightPosition.x, gWindowLightPosition.y, gWindowLightPosition.z);
-    const glm::vec3 cameraPosition = gCamera.Position;
-    glUniform3f(viewPositionLoc, cameraPosition.x, cameraPosition.y, cameraPosition.z);
+    // Group draws by program, material and VAO, then front to back; recorded draws come out sorted
+    if (!gRecordOnThreads)
+        gRenderQueue.Sort(gMaterials);
+    if (!gRecordOnThreads && (gRenderQueue.gStateChangesUnsorted != gLastStateChangesUnsorted || gRenderQueue.gStateChangesSorted != gLastStateChangesSorted))
+    {
+        cout << "INFO: State changes per frame: " << gRenderQueue.gStateChangesUnsorted << " in scene order, " << gRenderQueue.gStateChangesSorted << " sorted" << endl;
+        gLastStateChangesUnsorted = gRenderQueue.gStateChangesUnsorted;
+        gLastStateChangesSorted = gRenderQueue.gStateChangesSorted;
+    }
 
     //------------------------------------------------------------------------------------
-    // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(meshes.gCylinderMesh.vao);
-
-    // Scales the cylinder
-    scale = glm::scale(glm::vec3(0.85f, 2.5f, 0.85f));
-    // Rotates cylinder one full time
-    rotation = glm::rotate(3.1415f, glm::vec3(1.0f, 0.0f, 0.0f));
-    // Place cylinder
-    translation = glm::translate(glm::vec3(-0.75f, 0.501f, -5.0f));
-    // Model matrix: transformations are applied right-to-left order
-    model = translation * rotation * scale;
-
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-    // Tile the textures
-    GLint UVScaleLoc = glGetUniformLocation(gProgramId, "uvScale");
-    glUniform2fv(UVScaleLoc, 1, glm::value_ptr(glm::vec2(0.80f, 1.0f)));
-
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTextureIdBottomCylinderLiquid);
-
-    // Draws the triangles
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 36);		//bottom
-    glDrawArrays(GL_TRIANGLE_FAN, 36, 36);		//top
-    glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
-
-    // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
-    //------------------------------------------------------------------------------------
-    // 
-    //------------------------------------------------------------------------------------
-    // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(meshes.gCylinderMesh.vao);
-
-    // Scales the cylinder top
-    scale = glm::scale(glm::vec3(0.85f, 0.75f, 0.85f));
-    // Rotates cylinder top one full time
-    rotation = glm::rotate(3.1415f, glm::vec3(1.0f, 0.0f, 0.0f));
-    // Place cylinder top
-    translation = glm::translate(glm::vec3(-0.75f, 1.25f, -5.0f));
-    // Model matrix: transformations are applied right-to-left order
-    model = translation * rotation * scale;
-
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTextureIdTopCylinderRibbed);
-
-    // Draws the triangles
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 36);		//bottom
-    glDrawArrays(GL_TRIANGLE_FAN, 36, 36);		//top
-    glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
-
-    // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
-    //------------------------------------------------------------------------------------
-    // 
-    //------------------------------------------------------------------------------------
-    // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(meshes.gConeMesh.vao);
-
-    // Scales the cone
-    scale = glm::scale(glm::vec3(0.85f, 0.5f, 0.85f));
-    // Rotates cone half a rotation
-    rotation = glm::rotate(0.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-    // Place cone
-    translation = glm::translate(glm::vec3(-0.75f, 1.25f, -5.0f));
-    // Model matrix: transformations are applied right-to-left order
-    model = translation * rotation * scale;
-
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTextureIdCone);
-
-    // Draws the triangles
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 36);		//bottom
-    glDrawArrays(GL_TRIANGLE_FAN, 36, 36);		//top
-    glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
-
-    // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
-    //------------------------------------------------------------------------------------
-    // 
+    // Draws every object of the scene, binding the shared VAO
+    if (gRecordOnThreads)
+        gRenderQueue.SubmitRecorded(gMaterials, gGLState);
+    else if (gOcclusionQueriesOn)
+        // Queries wrap single draws, so this path never goes through the indirect buffer
+        gRenderQueue.SubmitQueried(gMaterials, gGLState, gOcclusionQueries, cameraPosition);
+    else if (gInstancedDraws)
+        gRenderQueue.SubmitInstanced(gMaterials, gGLState);
+    else if (gIndirectDraws)
+        gRenderQueue.SubmitIndirect(gMaterials, gGLState);
+    else
+        gRenderQueue.Submit(gMaterials, gGLState);
+
+    if (gOcclusionQueriesOn && ++gOcclusionQueryFrames == OCCLUSION_QUERY_REPORT_FRAMES)
+    {
+        cout << "INFO: Occlusion queries: " << gOcclusionQueries.gIssued << " issued over " << OCCLUSION_QUERY_REPORT_FRAMES << " frames, results after "
+            << (GLfloat)gOcclusionQueries.gLatencyFrames / max(gOcclusionQueries.gResults, 1u) << " frames on average, "
+            << gOcclusionQueries.gSkipped << " of " << gOcclusionQueries.gConditional << " conditional draws skipped" << endl;
+        gOcclusionQueries.ResetCounters();
+        gOcclusionQueryFrames = 0;
+    }
+
+    // The VAO stays bound, the state cache drops the rebind next frame
     //------------------------------------------------------------------------------------
-    // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(meshes.gPlaneMesh.vao);
+    // glfw: swap buffers and poll IO events
+    // Flips the the back buffer with the front buffer every frame.
+    glfwSwapBuffers(gWindow);
+}
 
-    // Scales the plane
-    scale = glm::scale(glm::vec3(2.5f, 1.0f, 2.5f));
-    // Rotates plane one full time
-    rotation = glm::rotate(3.1415f, glm::vec3(1.0f, 0.0f, 0.0f));
-    // Place plane in the middle of the screen
-    translation = glm::translate(glm::vec3(0.0f, 3.0f, -3.0f));
-    // Model matrix: transformations are applied right-to-left order
-    model = translation * rotation * scale;
 
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+// Culls, picks detail levels and writes the draws of the frame on the GPU, then keeps its depth for the next one
+void URenderGpuCulled(const RenderView& renderView, const glm::mat4& viewProjection)
+{
+    gRenderQueue.SubmitGpuCulled(gMaterials, gGLState, gGpuCulling, renderView);
 
-    // Tile the texture
-    UVScaleLoc = glGetUniformLocation(gProgramId, "uvScale");
-    glUniform2fv(UVScaleLoc, 1, glm::value_ptr(glm::vec2(1.0f, 1.2f)));
+    int width, height;
+    glfwGetFramebufferSize(gWindow, &width, &height);
+    gGpuCulling.BuildDepthPyramid(gGLState, width, height, viewProjection);
 
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTextureIdPlane);
+    if (++gGpuCullingFrames == GPU_CULL_REPORT_FRAMES)
+    {
+        cout << "INFO: GPU culling drew " << gGpuCulling.ReadVisibleCount() << " of " << gGpuCulling.gObjectCount << " objects in "
+            << gRenderQueue.gDrawCalls << " draw calls" << endl;
+        gGpuCullingFrames = 0;
+    }
+}
 
-    // Draws the triangles
-    glDrawElements(GL_TRIANGLES, meshes.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL); // Draws the triangle
 
-    // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
-    //------------------------------------------------------------------------------------
-    // 
-    //------------------------------------------------------------------------------------
-    // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(meshes.gSphereMesh.vao);
+// Camera and lighting data of a frame
+FrameBlock UBuildFrameBlock(const glm::mat4& view, const glm::mat4& projection)
+{
+    FrameBlock frame;
+    frame.view = view;
+    frame.projection = projection;
+    frame.viewPosition = glm::vec4(gCamera.Position, 1.0f);
+    frame.lightColor = glm::vec4(gLightColor, 1.0f);
+    frame.lightPos = glm::vec4(gLightPosition, 1.0f);
+    frame.windowLightColor = glm::vec4(gWindowLightColor, 1.0f);
+    frame.windowLightPos = glm::vec4(gWindowLightPosition, 1.0f);
+    return frame;
+}
 
-    // Scales the sphere
-    scale = glm::scale(glm::vec3(1.01f, 1.1f, 1.1f));
-    // Rotates sphere one full time
-    rotation = glm::rotate(0.0f, glm::vec3(0.0f, 1.0f, 0.0f));
-    // Place sphere
-    translation = glm::translate(glm::vec3(2.25f, -0.9f, -3.25f));
-    // Model matrix: transformations are applied right-to-left order
-    model = translation * rotation * scale;
 
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+// Runs the benchmarks and self-tests of --self-test, true when every check passed
+bool URunSelfTests(const string& fragmentSource)
+{
+    bool passed = true;
+    passed = UBenchmarkMeshCache() && passed;
+    UBenchmarkSubmission();
+    UBenchmarkNormalMatrix(fragmentSource);
+    passed = UTestOcclusionQueries() && passed;
+    passed = UTestGpuCulling() && passed;
+    passed = UBenchmarkInstancing() && passed;
+    passed = UBenchmarkStaticBatching() && passed;
+    passed = UTestCommandRecording() && passed;
+    return passed;
+}
 
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTextureIdSphere);
 
-    // Draws the triangles
-    glDrawElements(GL_TRIANGLES, meshes.gSphereMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+// Times CreateMeshes building every mesh against loading them from the cache it wrote;
+// returns true when both produced the same meshes and buffers
+bool UBenchmarkMeshCache()
+{
+    const GLuint nRuns = 3;
 
-    // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
-    //------------------------------------------------------------------------------------
-    // 
-    //------------------------------------------------------------------------------------
-    // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(meshes.gCubeMesh.vao);
+    // Contents of one of the shared buffers
+    auto UReadBuffer = [](GLuint buffer)
+    {
+        GLint size = 0;
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+        vector<GLubyte> data(size);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, size, data.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        return data;
+    };
+
+    // Best of a few runs each way; every cold run rewrites the cache the warm run after it loads
+    double times[2] = { 0.0, 0.0 };
+    bool loadedCache = true;
+    bool matches = true;
+    for (GLuint run = 0; run < nRuns; ++run)
+    {
+        Meshes built, loaded;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        built.CreateMeshes(MESH_VERTEX_FORMAT, false);
+        double buildTime = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        start = chrono::steady_clock::now();
+        loaded.CreateMeshes(MESH_VERTEX_FORMAT);
+        double loadTime = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        if (run == 0 || buildTime < times[0])
+            times[0] = buildTime;
+        if (run == 0 || loadTime < times[1])
+            times[1] = loadTime;
+        loadedCache = loadedCache && loaded.gFromCache;
+
+        const Meshes::GLMesh* builtMeshes[] = { &built.gCylinderMesh, &built.gConeMesh, &built.gPlaneMesh, &built.gSphereMesh, &built.gCubeMesh, &built.gHexagonMesh };
+        const Meshes::GLMesh* loadedMeshes[] = { &loaded.gCylinderMesh, &loaded.gConeMesh, &loaded.gPlaneMesh, &loaded.gSphereMesh, &loaded.gCubeMesh, &loaded.gHexagonMesh };
+        for (GLuint i = 0; i < Meshes::MESH_COUNT; ++i)
+            matches = matches && memcmp(builtMeshes[i], loadedMeshes[i], sizeof(Meshes::GLMesh)) == 0;
+        for (GLuint b = 0; b < 2; ++b)
+            matches = matches && UReadBuffer(built.gVbos[b]) == UReadBuffer(loaded.gVbos[b]);
+
+        built.DestroyMeshes();
+        loaded.DestroyMeshes();
+    }
+    // Creating the meshes bound their VAOs behind the state cache
+    gGLState.Invalidate();
+
+    cout << "INFO: CreateMeshes took " << times[0] << " ms building every mesh, " << times[1] << " ms loading them from the cache" << endl;
+    if (!loadedCache)
+        cout << "ERROR: CreateMeshes did not load the cache it had just written" << endl;
+    if (!matches)
+        cout << "ERROR: Meshes loaded from the cache differ from the ones built" << endl;
+    return loadedCache && matches;
+}
 
-    // Scales the cube (playing cards)
-    scale = glm::scale(glm::vec3(3.25f, 0.75f, 2.1f));
-    // Rotates cube (playing cards) half a rotation
-    rotation = glm::rotate(1.5707963f, glm::vec3(0.0f, 1.0f, 0.0f));
-    // Place cube (playing cards)
-    translation = glm::translate(glm::vec3(-3.25f, -1.615f, -1.75f));
-    // Model matrix: transformations are applied right-to-left order
-    model = translation * rotation * scale;
 
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+// Times the CPU side of both submission paths for growing copies of the scene
+void UBenchmarkSubmission()
+{
+    const GLuint sceneSize = sizeof(SCENE) / sizeof(SCENE[0]);
+    const GLuint objectCounts[] = { sceneSize, 1000, 100000 };
+
+    RenderView renderView;
+    renderView.cameraPosition = gCamera.Position;
+    // Every copy is submitted, whether the camera sees it or not
+    renderView.frustum = UUnboundedFrustum();
+    renderView.occlusion = nullptr;
+    renderView.perspective = true;
+    renderView.pixelError = LOD_PIXEL_ERROR;
+    renderView.unitsPerPixel = 2.0f * std::tan(glm::radians(gCamera.Zoom) * 0.5f) / WINDOW_HEIGHT;
+
+    for (GLuint nObjects : objectCounts)
+    {
+        // Copies of the scene laid out on a grid behind the original
+        vector<SceneObject> scene(nObjects);
+        for (GLuint i = 0; i < nObjects; ++i)
+        {
+            GLuint copy = i / sceneSize;
+            scene[i] = SCENE[i % sceneSize];
+            scene[i].translation += glm::vec3((GLfloat)(copy % 100) * 10.0f, 0.0f, -(GLfloat)(copy / 100) * 10.0f);
+        }
 
-    // Tile the texture
-    UVScaleLoc = glGetUniformLocation(gProgramId, "uvScale");
-    glUniform2fv(UVScaleLoc, 1, glm::value_ptr(glm::vec2(1.0f, 1.0f)));
+        RenderQueue queue;
+        queue.SetScene(scene.data(), nObjects);
+        queue.CreateIndirectBuffers(meshes);
+        // Creating the buffers bound the VAO behind the state cache
+        gGLState.Invalidate();
+        queue.BuildPackets(meshes, gMaterials, renderView);
+        queue.Sort(gMaterials);
+
+        // Each path runs once untimed so buffer growth and driver warm-up stay out of the numbers
+        queue.Submit(gMaterials, gGLState);
+        queue.SubmitIndirect(gMaterials, gGLState);
+        glFinish();
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        queue.Submit(gMaterials, gGLState);
+        double directTime = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        GLuint directCalls = queue.gDrawCalls;
+        glFinish();
+
+        start = chrono::steady_clock::now();
+        queue.SubmitIndirect(gMaterials, gGLState);
+        double indirectTime = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        glFinish();
+
+        cout << "INFO: Submitting " << nObjects << " objects took " << directTime << " ms in " << directCalls << " draw calls, "
+            << indirectTime << " ms indirect in " << queue.gDrawCalls << " draw calls" << endl;
+
+        queue.DestroyIndirectBuffers();
+    }
 
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTextureIdCubeCards);
+    gGLState.BindVertexArray(0);
+    gGLState.ResetCounters();
+}
 
-    // Draws the triangles
-    glDrawElements(GL_TRIANGLES, meshes.gCubeMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+// Renders a grid of spheres one draw at a time and instanced, timing both and comparing the images;
+// returns true when the images matched
+bool UBenchmarkInstancing()
+{
+    const GLuint sphereCounts[] = { 1000, 10000 };
+    const GLuint nRuns = 5;
+    bool matched = true;
+
+    glm::mat4 projection = glm::perspective(glm::radians(gCamera.Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+    UUpdateFrameBlock(gFrameBlockId, UBuildFrameBlock(gCamera.GetViewMatrix(), projection));
+    gMaterialTextures.BindMaterialTextures(gGLState);
+    gGLState.Enable(GL_DEPTH_TEST);
+
+    RenderView renderView;
+    renderView.cameraPosition = gCamera.Position;
+    renderView.frustum = UUnboundedFrustum();
+    renderView.occlusion = nullptr;
+    renderView.perspective = true;
+    renderView.pixelError = LOD_PIXEL_ERROR;
+    renderView.unitsPerPixel = 2.0f * std::tan(glm::radians(gCamera.Zoom) * 0.5f) / WINDOW_HEIGHT;
+
+    GLuint query;
+    glGenQueries(1, &query);
+    for (GLuint nSpheres : sphereCounts)
+    {
+        // Rows of 100 small spheres on the floor, stepping away from the camera
+        vector<SceneObject> scene(nSpheres);
+        for (GLuint i = 0; i < nSpheres; ++i)
+        {
+            scene[i] = SCENE[0];
+            scene[i].mesh = &meshes.gSphereMesh;
+            scene[i].material = MATERIAL_SPHERE;
+            scene[i].scale = glm::vec3(0.1f);
+            scene[i].rotationAngle = 0.0f;
+            scene[i].rotationAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+            scene[i].translation = glm::vec3(((GLfloat)(i % 100) - 49.5f) * 0.3f, -0.9f, -2.0f - (GLfloat)(i / 100) * 0.3f);
+            scene[i].uvScale = glm::vec2(1.0f);
+            scene[i].occluder = false;
+        }
 
-    // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
-    //------------------------------------------------------------------------------------
-    // 
-    //------------------------------------------------------------------------------------
-        // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(meshes.gHexagonMesh.vao);
+        RenderQueue queue;
+        queue.SetScene(scene.data(), nSpheres);
+        queue.CreateIndirectBuffers(meshes);
+        queue.CreateInstanceBuffers(meshes);
+        // Creating the buffers bound VAOs behind the state cache
+        gGLState.Invalidate();
+        queue.BuildPackets(meshes, gMaterials, renderView);
+        queue.Sort(gMaterials);
+
+        // Best CPU and GPU time of a few runs per path, after one untimed run that warms it up
+        vector<GLubyte> images[2];
+        double cpuTimes[2];
+        double gpuTimes[2];
+        GLuint drawCalls[2];
+        for (GLuint path = 0; path < 2; ++path)
+        {
+            for (GLuint run = 0; run <= nRuns; ++run)
+            {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                glBeginQuery(GL_TIME_ELAPSED, query);
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                if (path == 0)
+                    queue.Submit(gMaterials, gGLState);
+                else
+                    queue.SubmitInstanced(gMaterials, gGLState);
+                double cpuTime = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+                glEndQuery(GL_TIME_ELAPSED);
+
+                GLuint64 nanoseconds = 0;
+                glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+                double gpuTime = nanoseconds / 1.0e6;
+                if (run == 1 || (run > 1 && cpuTime < cpuTimes[path]))
+                    cpuTimes[path] = cpuTime;
+                if (run == 1 || (run > 1 && gpuTime < gpuTimes[path]))
+                    gpuTimes[path] = gpuTime;
+            }
+            drawCalls[path] = queue.gDrawCalls;
+
+            images[path].resize(WINDOW_WIDTH * WINDOW_HEIGHT * 4);
+            glReadPixels(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, images[path].data());
+        }
 
-    // Scales the hexagon
-    scale = glm::scale(glm::vec3(0.4f, 0.6f, 0.4f));
-    // Rotates hexagon
-    rotation = glm::rotate(0.0f, glm::vec3(0.0f, 1.0f, 0.0f));
-    // Place hexagon
-    translation = glm::translate(glm::vec3(1.5f, -1.95f, 1.0f));
-    // Model matrix: transformations are applied right-to-left order
-    model = translation * rotation * scale;
+        cout << "INFO: " << nSpheres << " spheres took " << cpuTimes[0] << " ms CPU, " << gpuTimes[0] << " ms GPU in " << drawCalls[0]
+            << " draw calls, instanced " << cpuTimes[1] << " ms CPU, " << gpuTimes[1] << " ms GPU in " << drawCalls[1] << " draw calls" << endl;
+        // Both paths feed the shader the same matrices, so they must draw the same pixels
+        if (images[0] != images[1])
+        {
+            cout << "ERROR: Instanced spheres do not match the ones drawn one at a time" << endl;
+            matched = false;
+        }
 
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+        queue.DestroyIndirectBuffers();
+        queue.DestroyInstanceBuffers();
+    }
+    glDeleteQueries(1, &query);
 
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTextureIdCoaster);
+    gGLState.BindVertexArray(0);
+    gGLState.ResetCounters();
+    return matched;
+}
 
-    // Draws the triangles
-    glDrawElements(GL_TRIANGLES, meshes.gHexagonMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+// Draws copies of the scene object by object at full detail and as static batches, timing both and comparing the images;
+// returns true when the bounds held and the images matched
+bool UBenchmarkStaticBatching()
+{
+    const GLuint sceneSize = sizeof(SCENE) / sizeof(SCENE[0]);
+    const GLuint nObjects = 1000;
+    const GLuint nRuns = 5;
 
-    // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
-    //------------------------------------------------------------------------------------
-    // glfw: swap buffers and poll IO events
-    // Flips the the back buffer with the front buffer every frame.
-    glfwSwapBuffers(gWindow);
+    vector<SceneObject> scene(nObjects);
+    for (GLuint i = 0; i < nObjects; ++i)
+    {
+        GLuint copy = i / sceneSize;
+        scene[i] = SCENE[i % sceneSize];
+        scene[i].translation += glm::vec3((GLfloat)(copy % 10) * 10.0f, 0.0f, -(GLfloat)(copy / 10) * 10.0f);
+    }
+
+    RenderQueue queue;
+    queue.SetScene(scene.data(), nObjects);
+    StaticBatches batches;
+    batches.CreateStaticBatches(meshes, queue.gObjects);
+    // Creating the batches bound their VAO behind the state cache
+    gGLState.Invalidate();
+
+    // Every batch must enclose the objects merged into it, or culling it would drop visible objects
+    bool boundsHold = true;
+    for (const RenderQueue::RenderObject& object : queue.gObjects)
+    {
+        for (const StaticBatches::Batch& batch : batches.gBatches)
+        {
+            if (batch.material != object.material)
+                continue;
+            for (GLuint axis = 0; axis < 3; ++axis)
+                boundsHold &= batch.worldBox.lower[axis] <= object.worldBox.lower[axis] + 1e-4f && batch.worldBox.upper[axis] >= object.worldBox.upper[axis] - 1e-4f;
+        }
+    }
+    if (!boundsHold)
+        cout << "ERROR: Static batch bounds do not enclose their objects" << endl;
+
+    glm::mat4 view = gCamera.GetViewMatrix();
+    glm::mat4 projection = glm::perspective(glm::radians(gCamera.Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+    UUpdateFrameBlock(gFrameBlockId, UBuildFrameBlock(view, projection));
+    gMaterialTextures.BindMaterialTextures(gGLState);
+    gGLState.Enable(GL_DEPTH_TEST);
+
+    // Batches hold the full detail level, so the objects are drawn at full detail too
+    RenderView renderView;
+    renderView.cameraPosition = gCamera.Position;
+    renderView.frustum = UExtractFrustum(projection * view);
+    renderView.occlusion = nullptr;
+    renderView.perspective = true;
+    renderView.pixelError = 0.0f;
+    renderView.unitsPerPixel = 2.0f * std::tan(glm::radians(gCamera.Zoom) * 0.5f) / WINDOW_HEIGHT;
+
+    // Best CPU and GPU time of a few runs per path, culling included, after one untimed run that warms it up
+    GLuint query;
+    glGenQueries(1, &query);
+    vector<GLubyte> images[2];
+    double cpuTimes[2];
+    double gpuTimes[2];
+    GLuint drawCalls[2];
+    for (GLuint path = 0; path < 2; ++path)
+    {
+        for (GLuint run = 0; run <= nRuns; ++run)
+        {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glBeginQuery(GL_TIME_ELAPSED, query);
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            if (path == 0)
+            {
+                queue.BuildPackets(meshes, gMaterials, renderView);
+                queue.Sort(gMaterials);
+                queue.Submit(gMaterials, gGLState);
+                drawCalls[path] = queue.gDrawCalls;
+            }
+            else
+            {
+                batches.Submit(gMaterials, gGLState, renderView.frustum);
+                drawCalls[path] = batches.gDrawCalls;
+            }
+            double cpuTime = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            glEndQuery(GL_TIME_ELAPSED);
+
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+            double gpuTime = nanoseconds / 1.0e6;
+            if (run == 1 || (run > 1 && cpuTime < cpuTimes[path]))
+                cpuTimes[path] = cpuTime;
+            if (run == 1 || (run > 1 && gpuTime < gpuTimes[path]))
+                gpuTimes[path] = gpuTime;
+        }
+
+        images[path].resize(WINDOW_WIDTH * WINDOW_HEIGHT * 4);
+        glReadPixels(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, images[path].data());
+    }
+    glDeleteQueries(1, &query);
+
+    // Transforms baked on the CPU round differently than on the GPU, so edge pixels may flip; colors must otherwise agree
+    GLuint nDiffering = 0;
+    for (size_t i = 0; i < images[0].size(); i += 4)
+    {
+        GLint largest = 0;
+        for (GLuint channel = 0; channel < 3; ++channel)
+            largest = std::max(largest, std::abs((GLint)images[0][i + channel] - (GLint)images[1][i + channel]));
+        nDiffering += largest > 8;
+    }
+    GLfloat differingPercent = 100.0f * nDiffering / (WINDOW_WIDTH * WINDOW_HEIGHT);
+
+    cout << "INFO: " << nObjects << " static objects took " << cpuTimes[0] << " ms CPU, " << gpuTimes[0] << " ms GPU in " << drawCalls[0]
+        << " draw calls, batched " << cpuTimes[1] << " ms CPU, " << gpuTimes[1] << " ms GPU in " << drawCalls[1] << " draw calls, "
+        << differingPercent << "% of pixels differ" << endl;
+    if (differingPercent > 1.0f)
+        cout << "ERROR: Static batches do not match the objects drawn one at a time" << endl;
+
+    batches.DestroyStaticBatches();
+    gGLState.BindVertexArray(0);
+    gGLState.ResetCounters();
+    return boundsHold && differingPercent <= 1.0f;
+}
+
+// Vertex stage cost of inverting the model for every vertex, against the normal matrix worked out once per object
+void UBenchmarkNormalMatrix(const string& fragmentSource)
+{
+    const GLuint sceneSize = sizeof(SCENE) / sizeof(SCENE[0]);
+    const GLuint nObjects = 1000;
+    const GLuint nRuns = 5;
+
+    vector<SceneObject> scene(nObjects);
+    for (GLuint i = 0; i < nObjects; ++i)
+    {
+        GLuint copy = i / sceneSize;
+        scene[i] = SCENE[i % sceneSize];
+        scene[i].translation += glm::vec3((GLfloat)(copy % 10) * 10.0f, 0.0f, -(GLfloat)(copy / 10) * 10.0f);
+    }
+
+    RenderQueue queue;
+    queue.SetScene(scene.data(), nObjects);
+
+    // The fast path must agree with the general inverse
+    GLfloat largestError = 0.0f;
+    for (const RenderQueue::RenderObject& object : queue.gObjects)
+    {
+        glm::mat3 reference = UNormalMatrix(object.model);
+        for (GLuint column = 0; column < 3; ++column)
+        {
+            glm::vec3 difference = glm::abs(object.normalMatrix[column] - reference[column]);
+            largestError = std::max(largestError, std::max(difference.x, std::max(difference.y, difference.z)));
+        }
+    }
+    if (largestError > 1e-4f)
+        cout << "WARNING: Normal matrix fast path is off by " << largestError << " from the general inverse" << endl;
+
+    // Software vertex stage: the normal transform of every full detail vertex, as the shader runs it. The model is
+    // read through a volatile pointer so the compiler cannot hoist the inverse out of the vertex loop
+    GLuint nVertices = 0;
+    glm::vec3 checksum(0.0f);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (const RenderQueue::RenderObject& object : queue.gObjects)
+    {
+        const glm::mat4* volatile model = &object.model;
+        const glm::vec3* normals = meshes.gNormals.data() + object.mesh->baseVertex;
+        for (GLuint v = 0; v < object.mesh->nVertices; ++v)
+            checksum += glm::mat3(glm::transpose(glm::inverse(*model))) * normals[v];
+        nVertices += object.mesh->nVertices;
+    }
+    double inverseTime = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    for (const RenderQueue::RenderObject& object : queue.gObjects)
+    {
+        const glm::vec3* normals = meshes.gNormals.data() + object.mesh->baseVertex;
+        for (GLuint v = 0; v < object.mesh->nVertices; ++v)
+            checksum += object.normalMatrix * normals[v];
+    }
+    double normalMatrixTime = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    cout << "INFO: Software vertex stage of " << nObjects << " objects (" << nVertices << " vertices): " << inverseTime << " ms with inverse() per vertex, "
+        << normalMatrixTime << " ms with the normal matrix (checksum " << checksum.x + checksum.y + checksum.z << ")" << endl;
+
+    // GPU timing against a copy of the vertex shader that still inverts the model for every vertex
+    string inverseSource = vertexShaderSource;
+    const string normalTransform = "drawNormalMatrix * localNormal";
+    size_t position = inverseSource.find(normalTransform);
+    if (position == string::npos)
+    {
+        cout << "WARNING: Normal transform not found in the vertex shader, skipping the GPU timing" << endl;
+        return;
+    }
+    inverseSource.replace(position, normalTransform.size(), "mat3(transpose(inverse(drawModel))) * localNormal");
+
+    GLuint inverseProgramId;
+    UniformTable inverseUniforms;
+    if (!UCreateShaderProgram(inverseSource.c_str(), fragmentSource.c_str(), inverseProgramId, inverseUniforms))
+        return;
+    inverseUniforms.Set(inverseUniforms.Find("uMaterialTextures"), 0);
+    inverseUniforms.Set(inverseUniforms.Find("packedVertices"), (GLint)(meshes.gVertexFormat == VERTEX_FORMAT_PACKED));
+
+    Material inverseMaterials[MATERIAL_COUNT];
+    for (GLuint m = 0; m < MATERIAL_COUNT; ++m)
+    {
+        inverseMaterials[m] = gMaterials[m];
+        inverseMaterials[m].program = &inverseUniforms;
+        inverseMaterials[m].uniforms = UFindDrawUniforms(inverseUniforms);
+    }
+
+    glm::mat4 projection = glm::perspective(glm::radians(gCamera.Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+    UUpdateFrameBlock(gFrameBlockId, UBuildFrameBlock(gCamera.GetViewMatrix(), projection));
+    gMaterialTextures.BindMaterialTextures(gGLState);
+    gGLState.Enable(GL_DEPTH_TEST);
+
+    queue.CreateIndirectBuffers(meshes);
+    // Creating the buffers bound the VAO behind the state cache
+    gGLState.Invalidate();
+
+    RenderView renderView;
+    renderView.cameraPosition = gCamera.Position;
+    // Every copy is submitted, whether the camera sees it or not
+    renderView.frustum = UUnboundedFrustum();
+    renderView.occlusion = nullptr;
+    renderView.perspective = true;
+    renderView.pixelError = LOD_PIXEL_ERROR;
+    renderView.unitsPerPixel = 2.0f * std::tan(glm::radians(gCamera.Zoom) * 0.5f) / WINDOW_HEIGHT;
+    queue.BuildPackets(meshes, gMaterials, renderView);
+    queue.Sort(gMaterials);
+
+    // Best of a few timed runs per program, after one untimed run that warms it up
+    GLuint query;
+    glGenQueries(1, &query);
+    const Material* programs[2] = { inverseMaterials, gMaterials };
+    double gpuTimes[2];
+    for (GLuint p = 0; p < 2; ++p)
+    {
+        gpuTimes[p] = 0.0;
+        for (GLuint run = 0; run <= nRuns; ++run)
+        {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glBeginQuery(GL_TIME_ELAPSED, query);
+            queue.SubmitIndirect(programs[p], gGLState);
+            glEndQuery(GL_TIME_ELAPSED);
+
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+            double time = nanoseconds / 1.0e6;
+            if (run == 1 || (run > 1 && time < gpuTimes[p]))
+                gpuTimes[p] = time;
+        }
+    }
+    glDeleteQueries(1, &query);
+
+    cout << "INFO: GPU time of " << nObjects << " objects: " << gpuTimes[0] << " ms with inverse() per vertex, "
+        << gpuTimes[1] << " ms with the normal matrix" << endl;
+
+    queue.DestroyIndirectBuffers();
+    gGLState.UseProgram(0);
+    UDestroyShaderProgram(inverseProgramId);
+}
+
+// Queries boxes against a known depth buffer and checks the visibility read back, true when every check passed
+bool UTestOcclusionQueries()
+{
+    // Camera at the origin looking down -z, the depth buffer cleared to a wall 5 units away
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+    glm::vec4 wall = projection * glm::vec4(0.0f, 0.0f, -5.0f, 1.0f);
+    UUpdateFrameBlock(gFrameBlockId, UBuildFrameBlock(glm::mat4(1.0f), projection));
+    gGLState.Enable(GL_DEPTH_TEST);
+    glClearDepth(wall.z / wall.w * 0.5 + 0.5);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    auto UBox = [](glm::vec3 center, GLfloat halfSize)
+    {
+        BoundingBox box;
+        box.lower = center - halfSize;
+        box.upper = center + halfSize;
+        return box;
+    };
+    const BoundingBox boxes[3] = { UBox(glm::vec3(0.0f, 0.0f, -10.0f), 0.5f), UBox(glm::vec3(0.0f, 0.0f, -3.0f), 0.5f), UBox(glm::vec3(0.0f), 0.5f) };
+    const bool expected[3] = { false, true, true };
+    const char* names[3] = { "box behind the depth is hidden", "box in front of the depth is visible", "box around the camera is visible" };
+
+    OcclusionQueries queries;
+    queries.CreateOcclusionQueries(3, &gBoxProgramUniforms);
+    queries.BeginFrame();
+    queries.BeginBoxQueries(gGLState);
+    for (GLuint i = 0; i < 3; ++i)
+        queries.QueryBox(i, boxes[i], glm::vec3(0.0f));
+    queries.EndBoxQueries();
+
+    // Waits here only so the results are in by the next frame
+    glFinish();
+    queries.BeginFrame();
+
+    GLuint nPassed = 0;
+    for (GLuint i = 0; i < 3; ++i)
+    {
+        bool passed = queries.WasVisible(i) == expected[i];
+        nPassed += passed;
+        if (!passed)
+            cout << "ERROR: Occlusion query check failed: " << names[i] << endl;
+    }
+    cout << "INFO: Occlusion query self-test passed " << nPassed << " of 3 checks, " << queries.gResults << " of "
+        << queries.gIssued << " queries read back" << endl;
+
+    queries.DestroyOcclusionQueries();
+    glClearDepth(1.0);
+    return nPassed == 3;
+}
+
+
+// Culls copies of the scene on the GPU and checks the commands against the CPU path, first by frustum, then with a depth pyramid;
+// returns true when every check passed
+bool UTestGpuCulling()
+{
+    const GLuint sceneSize = sizeof(SCENE) / sizeof(SCENE[0]);
+    const GLuint nObjects = 100000;
+    const GLuint NOT_DRAWN = ~0u;
+
+    // Copies of the scene laid out on a grid around the original
+    vector<SceneObject> scene(nObjects);
+    for (GLuint i = 0; i < nObjects; ++i)
+    {
+        GLuint copy = i / sceneSize;
+        scene[i] = SCENE[i % sceneSize];
+        scene[i].translation += glm::vec3(((GLfloat)(copy % 100) - 50.0f) * 10.0f, 0.0f, -(GLfloat)(copy / 100) * 10.0f);
+    }
+
+    RenderQueue queue;
+    queue.SetScene(scene.data(), nObjects);
+    queue.CreateIndirectBuffers(meshes);
+    GpuCulling culling;
+    culling.CreateGpuCulling(&gCullProgramUniforms, &gPyramidProgramUniforms);
+    queue.UploadGpuScene(meshes, gMaterials, culling);
+    // Creating the buffers and textures bound objects behind the state cache
+    gGLState.Invalidate();
+
+    glm::mat4 view = gCamera.GetViewMatrix();
+    glm::mat4 projection = glm::perspective(glm::radians(gCamera.Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+    glm::mat4 viewProjection = projection * view;
+    RenderView renderView;
+    renderView.cameraPosition = gCamera.Position;
+    renderView.frustum = UExtractFrustum(viewProjection);
+    renderView.occlusion = nullptr;
+    renderView.perspective = true;
+    renderView.pixelError = LOD_PIXEL_ERROR;
+    renderView.unitsPerPixel = 2.0f * std::tan(glm::radians(gCamera.Zoom) * 0.5f) / WINDOW_HEIGHT;
+
+    UUpdateFrameBlock(gFrameBlockId, UBuildFrameBlock(view, projection));
+    gMaterialTextures.BindMaterialTextures(gGLState);
+    gGLState.Enable(GL_DEPTH_TEST);
+
+    GLuint nChecks = 0;
+    GLuint nPassed = 0;
+    auto UCheck = [&](bool passed, const char* name)
+    {
+        ++nChecks;
+        nPassed += passed;
+        if (!passed)
+            cout << "ERROR: GPU culling check failed: " << name << endl;
+    };
+
+    // First index of the detail level drawn for every object, as the GPU wrote the commands
+    auto UReadCommands = [&](vector<GLuint>& drawn)
+    {
+        vector<DrawElementsIndirectCommand> commands(nObjects);
+        vector<GLuint> counts(culling.gGroups.size());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, culling.gCommandBuffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(DrawElementsIndirectCommand) * nObjects, commands.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, culling.gCountBuffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint) * counts.size(), counts.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        drawn.assign(nObjects, NOT_DRAWN);
+        for (GLuint group = 0; group < counts.size(); ++group)
+        {
+            for (GLuint c = culling.gGroups[group].firstCommand; c < culling.gGroups[group].firstCommand + counts[group]; ++c)
+                drawn[commands[c].baseInstance] = commands[c].firstIndex;
+        }
+    };
+
+    // CPU reference: the packets BuildPackets makes, frustum culled with their detail levels picked
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    queue.BuildPackets(meshes, gMaterials, renderView);
+    double cpuTime = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    vector<GLuint> reference(nObjects, NOT_DRAWN);
+    for (const DrawPacket& packet : queue.gPackets)
+        reference[packet.object] = packet.firstIndex;
+
+    // Frame without a depth pyramid: frustum culling and detail levels only, timed after a first run compiles the pass
+    culling.Cull(gGLState, renderView.frustum, renderView.cameraPosition, renderView.perspective, renderView.unitsPerPixel, renderView.pixelError);
+    GLuint timer;
+    glGenQueries(1, &timer);
+    glBeginQuery(GL_TIME_ELAPSED, timer);
+    culling.Cull(gGLState, renderView.frustum, renderView.cameraPosition, renderView.perspective, renderView.unitsPerPixel, renderView.pixelError);
+    glEndQuery(GL_TIME_ELAPSED);
+    GLuint64 gpuNanoseconds = 0;
+    glGetQueryObjectui64v(timer, GL_QUERY_RESULT, &gpuNanoseconds);
+    glDeleteQueries(1, &timer);
+
+    vector<GLuint> drawn;
+    UReadCommands(drawn);
+    UCheck(drawn == reference, "frustum culling and detail levels match the CPU");
+
+    // Draw the frame, then reduce its depth
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    queue.SubmitGpuCulled(gMaterials, gGLState, culling, renderView);
+    int width, height;
+    glfwGetFramebufferSize(gWindow, &width, &height);
+    vector<GLfloat> depth((size_t)width * height);
+    glReadPixels(0, 0, width, height, GL_DEPTH_COMPONENT, GL_FLOAT, depth.data());
+    culling.BuildDepthPyramid(gGLState, width, height, viewProjection);
+
+    // The same reduction on the CPU, level by level
+    vector<vector<GLfloat>> levels(culling.gPyramidLevels);
+    vector<GLuint> levelWidths(culling.gPyramidLevels);
+    vector<GLuint> levelHeights(culling.gPyramidLevels);
+    bool pyramidMatches = true;
+    gGLState.ActiveTexture(GL_TEXTURE0 + GPU_CULL_PYRAMID_UNIT);
+    gGLState.BindTexture(GL_TEXTURE_2D, culling.gPyramid);
+    for (GLuint level = 0; level < culling.gPyramidLevels; ++level)
+    {
+        const vector<GLfloat>& source = level == 0 ? depth : levels[level - 1];
+        GLuint sourceWidth = level == 0 ? width : levelWidths[level - 1];
+        GLuint sourceHeight = level == 0 ? height : levelHeights[level - 1];
+        levelWidths[level] = max(culling.gPyramidWidth >> level, 1u);
+        levelHeights[level] = max(culling.gPyramidHeight >> level, 1u);
+
+        levels[level].resize(levelWidths[level] * levelHeights[level]);
+        for (GLuint y = 0; y < levelHeights[level]; ++y)
+        {
+            for (GLuint x = 0; x < levelWidths[level]; ++x)
+            {
+                GLuint lastX = min(x == levelWidths[level] - 1 ? sourceWidth - 1 : 2 * x + 1, sourceWidth - 1);
+                GLuint lastY = min(y == levelHeights[level] - 1 ? sourceHeight - 1 : 2 * y + 1, sourceHeight - 1);
+                GLfloat farthest = 0.0f;
+                for (GLuint sy = 2 * y; sy <= lastY; ++sy)
+                {
+                    for (GLuint sx = 2 * x; sx <= lastX; ++sx)
+                        farthest = max(farthest, source[sy * sourceWidth + sx]);
+                }
+                levels[level][y * levelWidths[level] + x] = farthest;
+            }
+        }
+
+        // Depth copies and reads may round the 24 bit depth to float differently, a few steps apart at most
+        vector<GLfloat> gpuLevel(levels[level].size());
+        glGetTexImage(GL_TEXTURE_2D, level, GL_RED, GL_FLOAT, gpuLevel.data());
+        for (size_t t = 0; t < gpuLevel.size(); ++t)
+            pyramidMatches &= std::fabs(gpuLevel[t] - levels[level][t]) <= 1.0f / (1 << 22);
+        // The reference below tests against what the GPU holds
+        levels[level] = gpuLevel;
+    }
+    UCheck(pyramidMatches, "depth pyramid matches a CPU reduction of the depth buffer");
+
+    // Reference depth test on the CPU pyramid, with the pixel and level arithmetic of the culling shader
+    auto UUnoccluded = [&](GLuint i)
+    {
+        glm::vec3 center(queue.gBounds.gBoxX[i], queue.gBounds.gBoxY[i], queue.gBounds.gBoxZ[i]);
+        glm::vec3 extent(queue.gBounds.gExtentX[i], queue.gBounds.gExtentY[i], queue.gBounds.gExtentZ[i]);
+        GLfloat lower[2] = { 1e30f, 1e30f };
+        GLfloat upper[2] = { -1e30f, -1e30f };
+        GLfloat nearest = 1.0f;
+        for (GLuint corner = 0; corner < 8; ++corner)
+        {
+            glm::vec3 direction((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f);
+            glm::vec4 clip = viewProjection * glm::vec4(center + extent * direction, 1.0f);
+            if (clip.w < 1e-4f)
+                return true;
+
+            GLfloat screen[2] = { (clip.x / clip.w * 0.5f + 0.5f) * width, (clip.y / clip.w * 0.5f + 0.5f) * height };
+            for (GLuint axis = 0; axis < 2; ++axis)
+            {
+                lower[axis] = min(lower[axis], screen[axis]);
+                upper[axis] = max(upper[axis], screen[axis]);
+            }
+            nearest = min(nearest, clip.z / clip.w * 0.5f + 0.5f);
+        }
+
+        GLint minPixel[2], maxPixel[2];
+        const GLint sizes[2] = { width, height };
+        for (GLuint axis = 0; axis < 2; ++axis)
+        {
+            minPixel[axis] = (GLint)min(max(std::floor(lower[axis]), 0.0f), (GLfloat)sizes[axis]);
+            maxPixel[axis] = (GLint)min(max(std::floor(upper[axis]), -1.0f), (GLfloat)sizes[axis] - 1.0f);
+            if (minPixel[axis] > maxPixel[axis])
+                return true;
+        }
+
+        GLuint level = 0;
+        GLint first[2], last[2];
+        while (true)
+        {
+            const GLint levelSizes[2] = { (GLint)levelWidths[level], (GLint)levelHeights[level] };
+            for (GLuint axis = 0; axis < 2; ++axis)
+            {
+                first[axis] = min(minPixel[axis] >> (level + 1), levelSizes[axis] - 1);
+                last[axis] = min(maxPixel[axis] >> (level + 1), levelSizes[axis] - 1);
+            }
+            if (level + 1 >= culling.gPyramidLevels || (last[0] - first[0] <= 1 && last[1] - first[1] <= 1))
+                break;
+            ++level;
+        }
+
+        GLfloat farthest = 0.0f;
+        for (GLint y = first[1]; y <= last[1]; ++y)
+        {
+            for (GLint x = first[0]; x <= last[0]; ++x)
+                farthest = max(farthest, levels[level][y * levelWidths[level] + x]);
+        }
+        return nearest <= farthest;
+    };
+
+    // Same view again, now against the depth of the frame before
+    culling.Cull(gGLState, renderView.frustum, renderView.cameraPosition, renderView.perspective, renderView.unitsPerPixel, renderView.pixelError);
+    UReadCommands(drawn);
+    GLuint nInFrustum = 0;
+    GLuint nHidden = 0;
+    for (GLuint i = 0; i < nObjects; ++i)
+    {
+        if (reference[i] == NOT_DRAWN)
+            continue;
+        ++nInFrustum;
+        if (!UUnoccluded(i))
+        {
+            reference[i] = NOT_DRAWN;
+            ++nHidden;
+        }
+    }
+    UCheck(drawn == reference, "depth pyramid culling matches the CPU");
+
+    cout << "INFO: GPU culling self-test passed " << nPassed << " of " << nChecks << " checks; " << nObjects << " objects culled in "
+        << gpuNanoseconds / 1e6 << " ms on the GPU against " << cpuTime << " ms for BuildPackets, "
+        << nInFrustum << " in the frustum, " << nHidden << " of them behind the depth of the frame before" << endl;
+
+    culling.DestroyGpuCulling();
+    queue.DestroyIndirectBuffers();
+    gGLState.BindVertexArray(0);
+    gGLState.ResetCounters();
+    return nPassed == nChecks;
 }
 
+// Records copies of the scene on growing thread counts, checking every stream against one thread and against BuildPackets;
+// returns true when every check passed
+bool UTestCommandRecording()
+{
+    const GLuint sceneSize = sizeof(SCENE) / sizeof(SCENE[0]);
+    const GLuint nObjects = 100000;
+    const GLuint nRuns = 3;
+
+    vector<SceneObject> scene(nObjects);
+    for (GLuint i = 0; i < nObjects; ++i)
+    {
+        GLuint copy = i / sceneSize;
+        scene[i] = SCENE[i % sceneSize];
+        scene[i].translation += glm::vec3(((GLfloat)(copy % 100) - 50.0f) * 10.0f, 0.0f, -(GLfloat)(copy / 100) * 10.0f);
+    }
+
+    RenderQueue queue;
+    queue.SetScene(scene.data(), nObjects);
+    queue.CreateIndirectBuffers(meshes);
+    // Creating the buffers bound the VAO behind the state cache
+    gGLState.Invalidate();
+
+    glm::mat4 view = gCamera.GetViewMatrix();
+    glm::mat4 projection = glm::perspective(glm::radians(gCamera.Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+    OcclusionBuffer occlusion;
+    occlusion.CreateOcclusionBuffer(thread::hardware_concurrency());
+    queue.RasterizeOccluders(meshes, projection * view, occlusion);
+
+    // Every copy is recorded, so the work grows with the scene; the occlusion test still drops some
+    RenderView renderView;
+    renderView.cameraPosition = gCamera.Position;
+    renderView.frustum = UUnboundedFrustum();
+    renderView.occlusion = &occlusion;
+    renderView.perspective = true;
+    renderView.pixelError = LOD_PIXEL_ERROR;
+    renderView.unitsPerPixel = 2.0f * std::tan(glm::radians(gCamera.Zoom) * 0.5f) / WINDOW_HEIGHT;
+
+    GLuint nChecks = 0;
+    GLuint nPassed = 0;
+    auto UCheck = [&](bool passed, const string& name)
+    {
+        ++nChecks;
+        nPassed += passed;
+        if (!passed)
+            cout << "ERROR: Command recording check failed: " << name << endl;
+    };
+    auto USameBytes = [](const auto& a, const auto& b)
+    {
+        return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), sizeof(a[0]) * a.size()) == 0);
+    };
+
+    // Reference: packets built and sorted on this thread
+    queue.BuildPackets(meshes, gMaterials, renderView);
+    queue.Sort(gMaterials);
+    GLuint referenceCulled = queue.gCulled;
+    GLuint referenceOccluded = queue.gOccluded;
+
+    queue.CreateCommandBuffers(1);
+    queue.RecordCommands(meshes, gMaterials, renderView);
+    CommandBuffer single = queue.gRecorded;
+
+    bool matchesPackets = single.commands.size() == queue.gOrder.size() && queue.gCulled == referenceCulled && queue.gOccluded == referenceOccluded;
+    for (GLuint i = 0; matchesPackets && i < single.commands.size(); ++i)
+    {
+        const DrawPacket& packet = queue.gPackets[queue.gOrder[i]];
+        matchesPackets = single.sortKeys[i] == packet.sortKey && single.vaos[i] == packet.vao && single.commands[i].firstIndex == packet.firstIndex
+            && single.commands[i].count == packet.nIndices && single.records[i].material == packet.material && single.records[i].model == *packet.model;
+    }
+    UCheck(matchesPackets, "one thread records the packets of BuildPackets in the order of Sort");
+
+    // Any thread count must record the same bytes, and the fastest of a few runs shows the scaling
+    vector<GLuint> threadCounts = { 1, 2, 4, 8 };
+    GLuint nCores = thread::hardware_concurrency();
+    if (nCores > 8)
+        threadCounts.push_back(nCores);
+    string timings;
+    for (GLuint nThreads : threadCounts)
+    {
+        queue.DestroyCommandBuffers();
+        queue.CreateCommandBuffers(nThreads);
+        double best = 0.0;
+        for (GLuint run = 0; run <= nRuns; ++run)
+        {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            queue.RecordCommands(meshes, gMaterials, renderView);
+            double time = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            if (run == 1 || (run > 1 && time < best))
+                best = time;
+        }
+        UCheck(USameBytes(queue.gRecorded.sortKeys, single.sortKeys) && USameBytes(queue.gRecorded.vaos, single.vaos)
+            && USameBytes(queue.gRecorded.commands, single.commands) && USameBytes(queue.gRecorded.records, single.records)
+            && queue.gCulled == referenceCulled && queue.gOccluded == referenceOccluded, to_string(nThreads) + " threads record the stream of one thread");
+        timings += (timings.empty() ? "" : ", ") + to_string(best) + " ms on " + to_string(nThreads);
+    }
+
+    // Replaying the stream issues what SubmitIndirect issues for the sorted packets, so the images match
+    UUpdateFrameBlock(gFrameBlockId, UBuildFrameBlock(view, projection));
+    gMaterialTextures.BindMaterialTextures(gGLState);
+    gGLState.Enable(GL_DEPTH_TEST);
+    vector<GLubyte> images[2];
+    for (GLuint path = 0; path < 2; ++path)
+    {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (path == 0)
+            queue.SubmitIndirect(gMaterials, gGLState);
+        else
+            queue.SubmitRecorded(gMaterials, gGLState);
+        images[path].resize(WINDOW_WIDTH * WINDOW_HEIGHT * 4);
+        glReadPixels(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, images[path].data());
+    }
+    UCheck(images[0] == images[1], "replayed commands draw the image of SubmitIndirect");
+
+    cout << "INFO: Command recording self-test passed " << nPassed << " of " << nChecks << " checks; " << single.commands.size() << " of "
+        << nObjects << " objects recorded in " << timings << " threads (" << nCores << " cores)" << endl;
+
+    occlusion.DestroyOcclusionBuffer();
+    queue.DestroyCommandBuffers();
+    queue.DestroyIndirectBuffers();
+    gGLState.BindVertexArray(0);
+    gGLState.ResetCounters();
+    return nPassed == nChecks;
+}
 
 /*Generate and load the texture*/
 bool UCreateTexture(const char* filename, GLuint& textureId)
@@ -795,14 +2126,33 @@ bool UCreateTexture(const char* filename, GLuint& textureId)
 }
 
 
-void UDestroyTexture(GLuint textureId)
+// 2x2 magenta and black checkerboard standing in for a texture that failed to load
+void UCreatePlaceholderTexture(GLuint& textureId)
 {
+    const unsigned char pixels[2 * 2 * 4] = {
+        255, 0, 255, 255,   0, 0, 0, 255,
+        0, 0, 0, 255,       255, 0, 255, 255,
+    };
+
     glGenTextures(1, &textureId);
+    glBindTexture(GL_TEXTURE_2D, textureId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+
+void UDestroyTexture(GLuint textureId)
+{
+    glDeleteTextures(1, &textureId);
 }
 
 
 // Implements the UCreateShaders function
-bool UCreateShaderProgram(const char* vtxShaderSource, const char* fragShaderSource, GLuint& programId)
+bool UCreateShaderProgram(const char* vtxShaderSource, const char* fragShaderSource, GLuint& programId, UniformTable& uniforms)
 {
     // Compilation and linkage error reporting
     int success = 0;
@@ -857,12 +2207,56 @@ bool UCreateShaderProgram(const char* vtxShaderSource, const char* fragShaderSou
         return false;
     }
 
+    // Enumerate the active uniforms once so frames never look them up by name
+    if (!uniforms.Reflect(programId))
+        return false;
+
+    // The per-frame block must match the C++ struct filling it
+    if (!UCheckFrameBlock(programId))
+        return false;
+
     glUseProgram(programId);    // Uses the shader program
 
     return true;
 }
 
 
+// Compiles and links a program with a single compute shader
+bool UCreateComputeProgram(const char* computeShaderSource, GLuint& programId, UniformTable& uniforms)
+{
+    // Compilation and linkage error reporting
+    int success = 0;
+    char infoLog[512];
+
+    programId = glCreateProgram();
+    GLuint computeShaderId = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(computeShaderId, 1, &computeShaderSource, NULL);
+
+    glCompileShader(computeShaderId);
+    glGetShaderiv(computeShaderId, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(computeShaderId, sizeof(infoLog), NULL, infoLog);
+        std::cout << "ERROR::SHADER::COMPUTE::COMPILATION_FAILED\n" << infoLog << std::endl;
+
+        return false;
+    }
+
+    glAttachShader(programId, computeShaderId);
+    glLinkProgram(programId);
+    glGetProgramiv(programId, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(programId, sizeof(infoLog), NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+
+        return false;
+    }
+
+    return uniforms.Reflect(programId);
+}
+
+
 void UDestroyShaderProgram(GLuint programId)
 {
     // Delete shader programs to unallocate resources
@@ -0,0 +1,85 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "tests.h"
+#include "frustum.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+// Culls a million random objects with the SIMD test and checks every answer against the reference test
+TestResults UTestFrustum()
+{
+	TestResults results = { "Frustum", 0, 0 };
+	const GLuint nObjects = 1000000;
+
+	// The scene's starting camera: 45 degree field of view in an 800 x 600 window, looking down -z
+	const glm::vec3 cameraPosition(0.0f, 1.5f, 10.0f);
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAt(cameraPosition, cameraPosition + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum = UExtractFrustum(projection * view);
+
+	// Boxes of up to 2 units scattered over a 200 unit cube around the camera, each with its bounding sphere
+	std::vector<BoundingBox> boxes(nObjects);
+	std::vector<BoundingSphere> spheres(nObjects);
+	CullBounds bounds;
+	bounds.Resize(nObjects);
+	GLuint seed = 1;
+	for (GLuint i = 0; i < nObjects; ++i)
+	{
+		GLfloat random[6];
+		for (GLfloat& value : random)
+		{
+			// Linear congruential generator, the same objects every run
+			seed = seed * 1664525u + 1013904223u;
+			value = (GLfloat)(seed >> 8) / (GLfloat)(1u << 24);
+		}
+		glm::vec3 center = cameraPosition + (glm::vec3(random[0], random[1], random[2]) - 0.5f) * 200.0f;
+		glm::vec3 extent = glm::vec3(random[3], random[4], random[5]);
+		boxes[i].lower = center - extent;
+		boxes[i].upper = center + extent;
+		spheres[i].center = center;
+		spheres[i].radius = glm::length(extent);
+		bounds.Set(i, boxes[i], spheres[i]);
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	GLuint nReferenceVisible = 0;
+	std::vector<unsigned char> reference(nObjects);
+	for (GLuint i = 0; i < nObjects; ++i)
+	{
+		reference[i] = UIsVisible(frustum, boxes[i], spheres[i]);
+		nReferenceVisible += reference[i];
+	}
+	double referenceTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	std::vector<unsigned char> visible;
+	GLuint nVisible = UCullBounds(frustum, bounds, visible);
+	double cullTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	GLuint mismatches = 0;
+	for (GLuint i = 0; i < nObjects; ++i)
+		mismatches += visible[i] != reference[i];
+	UCheck(results, mismatches == 0, "batched culling agrees with the reference on every object");
+	UCheck(results, nVisible == nReferenceVisible, "batched culling counts the visible objects of the reference");
+
+	// Ranges that do not start or end on a SIMD batch, as threads cull them
+	const GLuint splits[] = { 0, 3, 4099, 500001, nObjects };
+	std::vector<unsigned char> ranged(nObjects);
+	GLuint nRangedVisible = 0;
+	for (GLuint r = 0; r + 1 < sizeof(splits) / sizeof(splits[0]); ++r)
+		nRangedVisible += UCullBounds(frustum, bounds, splits[r], splits[r + 1], ranged.data());
+	UCheck(results, ranged == reference && nRangedVisible == nReferenceVisible, "culling in unaligned ranges agrees with the reference");
+
+	std::cout << "INFO: Frustum culling " << nObjects << " objects took " << referenceTime << " ms one by one, " << cullTime << " ms in SIMD batches, "
+		<< nVisible << " visible" << std::endl;
+
+	return results;
+}
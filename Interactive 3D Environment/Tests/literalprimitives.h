@@ -0,0 +1,29 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+// Number of hand-written tables the parametric generator replaced
+const GLuint LITERAL_PRIMITIVE_COUNT = 3;
+
+/* One of the literal vertex tables Meshes used before the generator, kept as they were
+ * so the generator can be benchmarked against them.
+ */
+struct LiteralPrimitive
+{
+	const char* name;
+	const GLfloat* verts;
+	GLuint nFloats;
+	GLuint floatsPerVertex;     // 8 when the table has normals and texture coords, 3 for positions only
+	const GLuint* indices;      // Null when the table was drawn with glDrawArrays
+	GLuint nIndices;
+	GLuint nTriangles;          // As drawn, fans and strips included
+};
+
+// Cylinder, cone and sphere
+extern const LiteralPrimitive LITERAL_PRIMITIVES[LITERAL_PRIMITIVE_COUNT];
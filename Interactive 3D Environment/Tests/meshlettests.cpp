@@ -0,0 +1,71 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "tests.h"
+#include "meshlets.h"
+#include "vertexcache.h"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+	// Triangles as sorted vertex triples, so two lists compare equal when they hold the same triangles
+	std::vector<std::array<GLuint, 3>> USortedTriangles(std::vector<std::array<GLuint, 3>> triangles)
+	{
+		for (std::array<GLuint, 3>& triangle : triangles)
+			std::sort(triangle.begin(), triangle.end());
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+}
+
+
+// Splits every generated primitive into meshlets, checks the tables hold each triangle once within the limits,
+// and that cluster culling never rejects a triangle a camera around the mesh could see
+TestResults UTestMeshlets()
+{
+	TestResults results = { "Meshlets", 0, 0 };
+
+	for (TestMesh& mesh : UGenerateTestMeshes())
+	{
+		// Meshes clusters the cache optimized order
+		GLuint nIndices = (GLuint)mesh.indices.size();
+		UOptimizeTriangleOrder(mesh.indices.data(), nIndices, mesh.verts.data(), mesh.nVertices);
+
+		MeshletTables tables;
+		GLuint nMeshlets = UBuildMeshlets(mesh.indices.data(), nIndices, mesh.verts.data(), tables);
+		UCheck(results, nMeshlets == tables.meshlets.size() && nMeshlets > 0, mesh.name + " adds its meshlets to the tables");
+
+		bool withinLimits = true;
+		std::vector<std::array<GLuint, 3>> clustered;
+		for (const Meshlet& meshlet : tables.meshlets)
+		{
+			withinLimits &= meshlet.nVertices <= MESHLET_MAX_VERTICES && meshlet.nTriangles <= MESHLET_MAX_TRIANGLES;
+			for (GLuint t = 0; t < meshlet.nTriangles; ++t)
+			{
+				std::array<GLuint, 3> triangle;
+				for (GLuint corner = 0; corner < 3; ++corner)
+					triangle[corner] = tables.vertices[meshlet.vertexOffset + tables.triangles[meshlet.triangleOffset + t * 3 + corner]];
+				clustered.push_back(triangle);
+			}
+		}
+		UCheck(results, withinLimits, mesh.name + " meshlets stay within the vertex and triangle limits");
+
+		std::vector<std::array<GLuint, 3>> original;
+		for (GLuint i = 0; i + 2 < nIndices; i += 3)
+			original.push_back({ mesh.indices[i], mesh.indices[i + 1], mesh.indices[i + 2] });
+		UCheck(results, USortedTriangles(clustered) == USortedTriangles(original), mesh.name + " meshlets hold every triangle once");
+
+		GLuint failures = UValidateMeshletCulling(tables, 0, nMeshlets, mesh.verts.data());
+		UCheck(results, failures == 0, mesh.name + " cluster culling rejects no visible triangle (" + std::to_string(failures) + " rejected)");
+
+		std::cout << "INFO: Split " << mesh.name << " into " << nMeshlets << " meshlets" << std::endl;
+	}
+	return results;
+}
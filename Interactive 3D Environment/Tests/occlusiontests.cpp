@@ -0,0 +1,136 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "tests.h"
+#include "occlusion.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// Quad occluders are placed by scale and translation
+	glm::mat4 UQuadModel(const glm::vec3& center, const glm::vec3& halfSize)
+	{
+		return glm::scale(glm::translate(glm::mat4(1.0f), center), halfSize);
+	}
+
+	BoundingBox UBox(const glm::vec3& center, GLfloat halfSize)
+	{
+		BoundingBox box;
+		box.lower = center - halfSize;
+		box.upper = center + halfSize;
+		return box;
+	}
+}
+
+
+// Checks the software occlusion buffer against hand-placed occluders and boxes, then times its threads
+TestResults UTestOcclusion()
+{
+	TestResults results = { "Occlusion", 0, 0 };
+
+	// Camera at the origin looking down -z
+	glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 2.0f, 0.1f, 100.0f);
+	const glm::vec3 quad[4] = { glm::vec3(-1.0f, -1.0f, 0.0f), glm::vec3(1.0f, -1.0f, 0.0f), glm::vec3(1.0f, 1.0f, 0.0f), glm::vec3(-1.0f, 1.0f, 0.0f) };
+	const GLuint counterClockwise[6] = { 0, 1, 2, 0, 2, 3 };
+	const GLuint clockwise[6] = { 0, 2, 1, 0, 3, 2 };
+
+	OcclusionBuffer occlusion;
+	occlusion.CreateOcclusionBuffer(4);
+
+	occlusion.BeginFrame(viewProjection);
+	occlusion.Rasterize();
+	UCheck(results, occlusion.IsVisible(UBox(glm::vec3(0.0f, 0.0f, -10.0f), 0.5f)), "empty buffer hides nothing");
+
+	// Wall across the whole view, 5 units away; pixels along the diagonal shared by its two triangles are
+	// covered by neither, so the wall is placed with its diagonal off screen
+	occlusion.BeginFrame(viewProjection);
+	occlusion.AddOccluder(quad, counterClockwise, 6, UQuadModel(glm::vec3(50.0f, -50.0f, -5.0f), glm::vec3(100.0f)));
+	occlusion.Rasterize();
+	UCheck(results, !occlusion.IsVisible(UBox(glm::vec3(0.0f, 0.0f, -10.0f), 0.5f)), "box behind a wall is hidden");
+	UCheck(results, occlusion.IsVisible(UBox(glm::vec3(0.0f, 0.0f, -3.0f), 0.5f)), "box in front of a wall is visible");
+	UCheck(results, occlusion.IsVisible(UBox(glm::vec3(0.0f, 0.0f, -5.0f), 0.5f)), "box through a wall is visible");
+	UCheck(results, occlusion.IsVisible(UBox(glm::vec3(0.0f, 0.0f, 0.0f), 0.5f)), "box around the camera is visible");
+
+	// Same wall wound the other way
+	occlusion.BeginFrame(viewProjection);
+	occlusion.AddOccluder(quad, clockwise, 6, UQuadModel(glm::vec3(50.0f, -50.0f, -5.0f), glm::vec3(100.0f)));
+	occlusion.Rasterize();
+	UCheck(results, !occlusion.IsVisible(UBox(glm::vec3(0.0f, 0.0f, -10.0f), 0.5f)), "clockwise wall hides too");
+
+	// Wall covering the left half of the view only
+	occlusion.BeginFrame(viewProjection);
+	occlusion.AddOccluder(quad, counterClockwise, 6, UQuadModel(glm::vec3(-50.0f, 0.0f, -5.0f), glm::vec3(50.0f, 100.0f, 1.0f)));
+	occlusion.Rasterize();
+	UCheck(results, !occlusion.IsVisible(UBox(glm::vec3(-3.0f, 0.0f, -10.0f), 0.5f)), "box behind the half wall is hidden");
+	UCheck(results, occlusion.IsVisible(UBox(glm::vec3(3.0f, 0.0f, -10.0f), 0.5f)), "box beside the half wall is visible");
+	UCheck(results, occlusion.IsVisible(UBox(glm::vec3(0.0f, 0.0f, -10.0f), 0.5f)), "box across the wall's edge is visible");
+
+	// Pixels the wall's edge only partly covers are left empty, those it fully covers hold its farthest depth;
+	// the edge is moved past the center of column OCCLUSION_WIDTH / 2, 0.7 pixels into it
+	occlusion.BeginFrame(viewProjection);
+	occlusion.AddOccluder(quad, counterClockwise, 6, UQuadModel(glm::vec3(-49.977f, 0.0f, -5.0f), glm::vec3(50.0f, 100.0f, 1.0f)));
+	occlusion.Rasterize();
+	glm::vec4 edgeClip = viewProjection * glm::vec4(0.0f, 0.0f, -5.0f, 1.0f);
+	GLfloat wallDepth = edgeClip.z / edgeClip.w * 0.5f + 0.5f;
+	const GLfloat* middleRow = &occlusion.gDepth[OCCLUSION_HEIGHT / 2 * OCCLUSION_WIDTH];
+	UCheck(results, middleRow[OCCLUSION_WIDTH / 2] == 1.0f, "pixel partly covered by the wall is empty");
+	UCheck(results, middleRow[OCCLUSION_WIDTH / 2 - 1] >= wallDepth && middleRow[OCCLUSION_WIDTH / 2 - 1] < 1.0f, "pixel left of the wall's edge holds the wall");
+
+	// Wall reaching behind the camera is dropped rather than clipped
+	occlusion.BeginFrame(viewProjection);
+	glm::mat4 floor = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+	floor = glm::rotate(floor, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+	occlusion.AddOccluder(quad, counterClockwise, 6, glm::scale(floor, glm::vec3(100.0f)));
+	occlusion.Rasterize();
+	UCheck(results, occlusion.gTriangles == 0, "occluder crossing the near plane is dropped");
+	UCheck(results, occlusion.IsVisible(UBox(glm::vec3(0.0f, -3.0f, -10.0f), 0.5f)), "dropped occluder hides nothing");
+	occlusion.DestroyOcclusionBuffer();
+
+	// Any number of threads writes the same depths as one
+	std::vector<glm::vec3> positions;
+	std::vector<GLuint> indices;
+	GLuint seed = 1;
+	for (GLuint i = 0; i < 3000; ++i)
+	{
+		GLfloat random[3];
+		for (GLfloat& value : random)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			value = (GLfloat)(seed >> 8) / (GLfloat)(1u << 24);
+		}
+		positions.push_back(glm::vec3((random[0] - 0.5f) * 20.0f, (random[1] - 0.5f) * 10.0f, -5.0f - random[2] * 50.0f));
+		indices.push_back(i);
+	}
+
+	double rasterizeTimes[2];
+	std::vector<GLfloat> depths[2];
+	const GLuint threadCounts[2] = { 1, std::max(4u, std::thread::hardware_concurrency()) };
+	for (GLuint run = 0; run < 2; ++run)
+	{
+		OcclusionBuffer threaded;
+		threaded.CreateOcclusionBuffer(threadCounts[run]);
+		threaded.BeginFrame(viewProjection);
+		threaded.AddOccluder(positions.data(), indices.data(), (GLuint)indices.size(), glm::mat4(1.0f));
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		threaded.Rasterize();
+		rasterizeTimes[run] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		depths[run] = threaded.gDepth;
+		threaded.DestroyOcclusionBuffer();
+	}
+	UCheck(results, depths[0] == depths[1], "threaded rasterization matches one thread");
+
+	std::cout << "INFO: Occlusion rasterized 1000 triangles in " << rasterizeTimes[0] << " ms on 1 thread, "
+		<< rasterizeTimes[1] << " ms on " << threadCounts[1] << std::endl;
+	return results;
+}
@@ -0,0 +1,173 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "tests.h"
+#include "literalprimitives.h"
+#include "primitives.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+	const GLuint BENCHMARK_RUNS = 2000;
+	// The literal tables were typed to two decimals
+	const GLfloat BOUNDS_TOLERANCE = 0.02f;
+	// M_PI of the old sphere code, which needs _USE_MATH_DEFINES on MSVC
+	const double LITERAL_PI = 3.14159265358979323846;
+
+	// Same descriptions Meshes builds the cylinder, cone and sphere from
+	PrimitiveDesc UPrimitiveDesc(GLuint shape, GLuint lod)
+	{
+		PrimitiveDesc desc;
+		desc.shape = shape == 2 ? PRIMITIVE_SPHERE : PRIMITIVE_CYLINDER;
+		desc.segments = shape == 2 ? SPHERE_LOD_SEGMENTS[lod] : CYLINDER_LOD_SEGMENTS[lod];
+		desc.rings = shape == 2 ? SPHERE_LOD_RINGS[lod] : 1;
+		desc.bottomRadius = 1.0f;
+		desc.topRadius = shape == 1 ? 0.5f : 1.0f;
+		return desc;
+	}
+
+
+	void UBounds(const GLfloat* verts, GLuint nVertices, GLuint floatsPerVertex, glm::vec3& lower, glm::vec3& upper)
+	{
+		lower = glm::vec3(1e30f);
+		upper = glm::vec3(-1e30f);
+		for (GLuint i = 0; i < nVertices; ++i)
+		{
+			glm::vec3 position(verts[i * floatsPerVertex], verts[i * floatsPerVertex + 1], verts[i * floatsPerVertex + 2]);
+			lower = glm::min(lower, position);
+			upper = glm::max(upper, position);
+		}
+	}
+
+
+	double UMicrosecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+
+/* Times the generator against the CPU work the old meshes did before uploading: copying the cylinder
+ * and cone tables, and for the positions-only sphere table, also building its normals and texture coords.
+ * Compares vertex and triangle counts too.
+ */
+TestResults UTestPrimitives()
+{
+	TestResults results = { "Primitives", 0, 0 };
+
+	for (GLuint shape = 0; shape < LITERAL_PRIMITIVE_COUNT; ++shape)
+	{
+		const LiteralPrimitive& literal = LITERAL_PRIMITIVES[shape];
+		GLuint nLiteralVertices = literal.nFloats / literal.floatsPerVertex;
+
+		// Old path: the table copied into the vertex and index data handed to glBufferData
+		std::vector<GLfloat> literalVerts;
+		std::vector<GLuint> literalIndices;
+		GLfloat checksum = 0.0f;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (GLuint run = 0; run < BENCHMARK_RUNS; ++run)
+		{
+			literalVerts.assign(literal.verts, literal.verts + literal.nFloats);
+			literalIndices.assign(literal.indices, literal.indices + literal.nIndices);
+			checksum += literalVerts[run % literal.nFloats];
+
+			// Positions-only tables were interleaved the way the old sphere did it, into a vector grown vertex by vertex
+			if (literal.floatsPerVertex == 3)
+			{
+				std::vector<GLfloat> combined;
+				for (GLuint i = 0; i < literal.nFloats; i += 3)
+				{
+					glm::vec3 vert(literalVerts[i], literalVerts[i + 1], literalVerts[i + 2]);
+					glm::vec3 normal = glm::normalize(vert - glm::vec3(0.0f));
+					GLfloat u = (GLfloat)(std::atan2(normal.x, normal.z) / (2 * LITERAL_PI) + 0.5);
+					GLfloat v = (GLfloat)(normal.y * 0.5 + 0.5);
+					combined.push_back(vert.x);
+					combined.push_back(vert.y);
+					combined.push_back(vert.z);
+					combined.push_back(normal.x);
+					combined.push_back(normal.y);
+					combined.push_back(normal.z);
+					combined.push_back(u);
+					combined.push_back(v);
+				}
+				checksum += combined[run % combined.size()];
+			}
+		}
+		double literalTime = UMicrosecondsSince(start) / BENCHMARK_RUNS;
+
+		// New path: every detail level generated into buffers sized up front, as Meshes does
+		PrimitiveSize sizes[PRIMITIVE_LOD_COUNT];
+		GLuint nVertices = 0, nIndices = 0;
+		for (GLuint lod = 0; lod < PRIMITIVE_LOD_COUNT; ++lod)
+		{
+			sizes[lod] = UPrimitiveSize(UPrimitiveDesc(shape, lod));
+			nVertices += sizes[lod].nVertices;
+			nIndices += sizes[lod].nIndices;
+		}
+		std::vector<GLfloat> verts(nVertices * PRIMITIVE_FLOATS_PER_VERTEX);
+		std::vector<GLuint> indices(nIndices);
+
+		double levelTimes[PRIMITIVE_LOD_COUNT];
+		GLuint vertexOffset = 0, indexOffset = 0;
+		for (GLuint lod = 0; lod < PRIMITIVE_LOD_COUNT; ++lod)
+		{
+			PrimitiveDesc desc = UPrimitiveDesc(shape, lod);
+			PrimitiveSize written;
+			start = std::chrono::steady_clock::now();
+			for (GLuint run = 0; run < BENCHMARK_RUNS; ++run)
+			{
+				written = UGeneratePrimitive(desc, &verts[vertexOffset * PRIMITIVE_FLOATS_PER_VERTEX], &indices[indexOffset], vertexOffset);
+				checksum += verts[vertexOffset * PRIMITIVE_FLOATS_PER_VERTEX + run % PRIMITIVE_FLOATS_PER_VERTEX];
+			}
+			levelTimes[lod] = UMicrosecondsSince(start) / BENCHMARK_RUNS;
+
+			std::string name = std::string(literal.name) + " level " + std::to_string(lod);
+			UCheck(results, written.nVertices == sizes[lod].nVertices && written.nIndices == sizes[lod].nIndices, name + " fills the size it reported");
+			bool inRange = true;
+			for (GLuint i = indexOffset; i < indexOffset + written.nIndices; ++i)
+				inRange = inRange && indices[i] >= vertexOffset && indices[i] < vertexOffset + written.nVertices;
+			UCheck(results, inRange, name + " indices stay within its vertices");
+			bool unitNormals = true;
+			for (GLuint i = vertexOffset; i < vertexOffset + written.nVertices; ++i)
+			{
+				const GLfloat* v = &verts[i * PRIMITIVE_FLOATS_PER_VERTEX];
+				unitNormals = unitNormals && std::fabs(glm::length(glm::vec3(v[3], v[4], v[5])) - 1.0f) < 1e-4f;
+			}
+			UCheck(results, unitNormals, name + " normals are unit length");
+
+			vertexOffset += written.nVertices;
+			indexOffset += written.nIndices;
+		}
+
+		// The most detailed level stands in for the old table, so it must cover the same shape without drawing more
+		glm::vec3 literalLower, literalUpper, lower, upper;
+		UBounds(literal.verts, nLiteralVertices, literal.floatsPerVertex, literalLower, literalUpper);
+		UBounds(verts.data(), sizes[0].nVertices, PRIMITIVE_FLOATS_PER_VERTEX, lower, upper);
+		GLfloat boundsError = std::max(glm::length(lower - literalLower), glm::length(upper - literalUpper));
+		UCheck(results, boundsError <= BOUNDS_TOLERANCE, std::string(literal.name) + " level 0 has the bounds of the literal table");
+		UCheck(results, sizes[0].nIndices / 3 <= literal.nTriangles, std::string(literal.name) + " level 0 draws no more triangles than the literal table");
+
+		std::cout << "INFO: " << literal.name << " literal table: " << nLiteralVertices << " vertices, " << literal.nTriangles
+			<< " triangles, " << literalTime << " us to copy" << (literal.floatsPerVertex == 3 ? " and interleave" : "") << std::endl;
+		for (GLuint lod = 0; lod < PRIMITIVE_LOD_COUNT; ++lod)
+		{
+			std::cout << "INFO: " << literal.name << " generated level " << lod << ": " << sizes[lod].nVertices << " vertices, "
+				<< sizes[lod].nIndices / 3 << " triangles, " << levelTimes[lod] << " us to generate" << std::endl;
+		}
+		// Keeps the timed loops from being optimized away
+		if (checksum != checksum)
+			std::cout << "WARNING: " << literal.name << " benchmark produced NaN" << std::endl;
+	}
+
+	return results;
+}
@@ -0,0 +1,96 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "tests.h"
+#include "primitives.h"
+#include "authoredmeshes.h"
+#include "weld.h"
+
+#include <cstdlib>
+#include <iostream>
+
+void UCheck(TestResults& results, bool passed, const std::string& check)
+{
+	++results.nChecks;
+	results.nPassed += passed;
+	if (!passed)
+		std::cout << "ERROR: " << results.suite << " check failed: " << check << std::endl;
+}
+
+
+std::vector<TestMesh> UGenerateTestMeshes()
+{
+	// Same shapes and detail levels as the cylinder, cone and sphere meshes
+	const char* const names[3] = { "cylinder", "cone", "sphere" };
+	std::vector<TestMesh> testMeshes;
+	for (GLuint shape = 0; shape < 3; ++shape)
+	{
+		for (GLuint lod = 0; lod < PRIMITIVE_LOD_COUNT; ++lod)
+		{
+			PrimitiveDesc desc;
+			desc.shape = shape == 2 ? PRIMITIVE_SPHERE : PRIMITIVE_CYLINDER;
+			desc.segments = shape == 2 ? SPHERE_LOD_SEGMENTS[lod] : CYLINDER_LOD_SEGMENTS[lod];
+			desc.rings = shape == 2 ? SPHERE_LOD_RINGS[lod] : 1;
+			desc.bottomRadius = 1.0f;
+			desc.topRadius = shape == 1 ? 0.5f : 1.0f;
+
+			TestMesh mesh;
+			mesh.name = std::string(names[shape]) + " level " + std::to_string(lod);
+			PrimitiveSize size = UPrimitiveSize(desc);
+			mesh.verts.resize(size.nVertices * PRIMITIVE_FLOATS_PER_VERTEX);
+			mesh.indices.resize(size.nIndices);
+			UGeneratePrimitive(desc, mesh.verts.data(), mesh.indices.data());
+
+			mesh.nVertices = UWeldVertices(mesh.verts.data(), size.nVertices, mesh.indices.data(), size.nIndices);
+			mesh.verts.resize(mesh.nVertices * PRIMITIVE_FLOATS_PER_VERTEX);
+			testMeshes.push_back(mesh);
+		}
+	}
+
+	// The typed out meshes, welded the same way
+	const char* const authoredNames[3] = { "plane", "cube", "hexagon" };
+	const AuthoredMesh authored[3] = { UAuthoredPlane(), UAuthoredCube(), UAuthoredHexagon() };
+	for (GLuint i = 0; i < 3; ++i)
+	{
+		TestMesh mesh;
+		mesh.name = authoredNames[i];
+		mesh.verts.assign(authored[i].verts, authored[i].verts + authored[i].nVertices * PRIMITIVE_FLOATS_PER_VERTEX);
+		mesh.indices.assign(authored[i].indices, authored[i].indices + authored[i].nIndices);
+		mesh.nVertices = UWeldVertices(mesh.verts.data(), authored[i].nVertices, mesh.indices.data(), authored[i].nIndices);
+		mesh.verts.resize(mesh.nVertices * PRIMITIVE_FLOATS_PER_VERTEX);
+		testMeshes.push_back(mesh);
+	}
+	return testMeshes;
+}
+
+
+// Runs every suite and fails when any check did
+int main()
+{
+	TestResults (*const suites[])() = {
+		UTestOcclusion,
+		UTestVertexCache,
+		UTestVertexFormat,
+		UTestMeshlets,
+		UTestPrimitives,
+		UTestFrustum,
+	};
+
+	GLuint nFailed = 0;
+	for (TestResults (*suite)() : suites)
+	{
+		TestResults results = suite();
+		std::cout << "INFO: " << results.suite << " passed " << results.nPassed << " of " << results.nChecks << " checks" << std::endl;
+		nFailed += results.nChecks - results.nPassed;
+	}
+
+	if (nFailed > 0)
+	{
+		std::cout << "ERROR: " << nFailed << " checks failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,45 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+// Checks run and passed by one suite
+struct TestResults
+{
+	const char* suite;
+	GLuint nChecks;
+	GLuint nPassed;
+};
+
+// One detail level of a generated primitive, welded the way Meshes welds it before optimizing
+struct TestMesh
+{
+	std::string name;
+	std::vector<GLfloat> verts;     // Interleaved float vertices (position, normal, texture coords)
+	std::vector<GLuint> indices;
+	GLuint nVertices;
+};
+
+// Counts a check, printing its name when it fails
+void UCheck(TestResults& results, bool passed, const std::string& check);
+
+// Every mesh of Meshes::CreateMeshes: each detail level of the generated cylinder, cone and sphere, then the authored plane, cube and hexagon
+std::vector<TestMesh> UGenerateTestMeshes();
+
+/* Suites of the CPU side modules, none of them needs a window or a GL context.
+ * Each returns its results; benchmarks inside a suite print their timings as INFO lines.
+ */
+TestResults UTestOcclusion();
+TestResults UTestVertexCache();
+TestResults UTestVertexFormat();
+TestResults UTestMeshlets();
+TestResults UTestPrimitives();
+TestResults UTestFrustum();
@@ -0,0 +1,81 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "tests.h"
+#include "primitives.h"
+#include "vertexcache.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+	// Triangles by the positions of their corners, each rotated to start at its smallest corner, then sorted.
+	// Two index buffers draw the same surface when their keys match, whatever the triangle and vertex order.
+	std::vector<std::array<GLfloat, 9>> UTriangleKeys(const std::vector<GLfloat>& verts, const std::vector<GLuint>& indices)
+	{
+		std::vector<std::array<GLfloat, 9>> keys;
+		for (GLuint t = 0; t + 2 < indices.size(); t += 3)
+		{
+			std::array<std::array<GLfloat, 3>, 3> corners;
+			for (GLuint c = 0; c < 3; ++c)
+			{
+				const GLfloat* position = &verts[indices[t + c] * PRIMITIVE_FLOATS_PER_VERTEX];
+				corners[c] = { position[0], position[1], position[2] };
+			}
+			GLuint first = (GLuint)(std::min_element(corners.begin(), corners.end()) - corners.begin());
+
+			std::array<GLfloat, 9> key;
+			for (GLuint c = 0; c < 3; ++c)
+				std::copy(corners[(first + c) % 3].begin(), corners[(first + c) % 3].end(), key.begin() + c * 3);
+			keys.push_back(key);
+		}
+		std::sort(keys.begin(), keys.end());
+		return keys;
+	}
+}
+
+
+// Optimizes every mesh and fails when the post-transform cache does worse than the generator's order
+TestResults UTestVertexCache()
+{
+	TestResults results = { "Vertex cache", 0, 0 };
+
+	// Vertices transformed over every mesh, before and after
+	GLfloat totalBefore = 0.0f, totalAfter = 0.0f;
+	for (TestMesh& mesh : UGenerateTestMeshes())
+	{
+		GLuint nIndices = (GLuint)mesh.indices.size();
+		std::vector<std::array<GLfloat, 9>> triangles = UTriangleKeys(mesh.verts, mesh.indices);
+		VertexCacheStats before = UAnalyzeVertexCache(mesh.indices.data(), nIndices, mesh.nVertices);
+
+		UOptimizeTriangleOrder(mesh.indices.data(), nIndices, mesh.verts.data(), mesh.nVertices);
+		VertexCacheStats reordered = UAnalyzeVertexCache(mesh.indices.data(), nIndices, mesh.nVertices);
+		UCheck(results, reordered.acmr <= before.acmr, mesh.name + " ACMR is no worse after reordering triangles");
+		UCheck(results, reordered.atvr <= before.atvr, mesh.name + " ATVR is no worse after reordering triangles");
+
+		// Renumbering vertices in fetch order cannot change which of them hit the cache
+		UOptimizeVertexFetch(mesh.verts.data(), mesh.nVertices, mesh.indices.data(), nIndices);
+		VertexCacheStats after = UAnalyzeVertexCache(mesh.indices.data(), nIndices, mesh.nVertices);
+		UCheck(results, after.acmr == reordered.acmr, mesh.name + " ACMR is unchanged by the vertex fetch order");
+
+		UCheck(results, UTriangleKeys(mesh.verts, mesh.indices) == triangles, mesh.name + " keeps every triangle");
+
+		totalBefore += before.acmr * nIndices / 3;
+		totalAfter += after.acmr * nIndices / 3;
+		std::cout << "INFO: Vertex cache of " << mesh.name << ", ACMR " << before.acmr << " -> " << after.acmr
+			<< ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+	}
+
+	// Most meshes are already in a cache friendly order, but the optimizer must gain something overall
+	UCheck(results, totalAfter < totalBefore, "optimizing lowers the vertices transformed over every mesh");
+	std::cout << "INFO: Vertex cache over every mesh, " << totalBefore << " -> " << totalAfter << " vertices transformed" << std::endl;
+	return results;
+}
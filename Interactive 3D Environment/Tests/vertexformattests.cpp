@@ -0,0 +1,93 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "tests.h"
+#include "primitives.h"
+#include "vertexformat.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+	// Largest errors the packed format may add, whatever format the application is built with
+	const GLfloat MAX_POSITION_STEPS = 0.5f;        // Of the 16-bit quantization step over the mesh bounds
+	const GLfloat MAX_NORMAL_DEGREES = 0.01f;
+	const GLfloat MAX_UV_ERROR = 1.0f / 4096.0f;    // Half float rounding of coords up to 1
+	// Slack for the float arithmetic of decoding
+	const GLfloat POSITION_SLACK = 1e-6f;
+
+	// Through atan2 rather than acos, which cannot resolve angles below about 0.02 degrees in floats
+	GLfloat UDegreesBetween(const glm::vec3& a, const glm::vec3& b)
+	{
+		return std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b)) * 57.2957795f;
+	}
+}
+
+
+// Packs every generated primitive, decodes it the way the vertex shader does and checks the errors against fixed limits
+TestResults UTestVertexFormat()
+{
+	TestResults results = { "Vertex format", 0, 0 };
+
+	for (const TestMesh& mesh : UGenerateTestMeshes())
+	{
+		std::vector<PackedVertex> packed(mesh.nVertices);
+		glm::vec3 positionOffset, positionScale;
+		PackingError reported;
+		UPackVertices(mesh.verts.data(), mesh.nVertices, packed.data(), positionOffset, positionScale, reported);
+
+		// Measured from the packed data, not taken from the packer's own report
+		PackingError measured = { 0.0f, 0.0f, 0.0f };
+		for (GLuint i = 0; i < mesh.nVertices; ++i)
+		{
+			const GLfloat* v = &mesh.verts[i * PRIMITIVE_FLOATS_PER_VERTEX];
+			const PackedVertex& p = packed[i];
+			for (GLuint axis = 0; axis < 3; ++axis)
+			{
+				GLfloat decoded = positionOffset[axis] + (p.position[axis] / 65535.0f) * positionScale[axis];
+				measured.position = std::max(measured.position, std::fabs(decoded - v[axis]));
+			}
+			glm::vec3 normal = glm::normalize(glm::vec3(v[3], v[4], v[5]));
+			measured.normalDegrees = std::max(measured.normalDegrees, UDegreesBetween(normal, UDecodeOctahedral(p.normal)));
+			for (GLuint axis = 0; axis < 2; ++axis)
+				measured.uv = std::max(measured.uv, std::fabs(glm::unpackHalf1x16(p.uv[axis]) - v[6 + axis]));
+		}
+
+		GLfloat extent = std::max(positionScale.x, std::max(positionScale.y, positionScale.z));
+		GLfloat maxPosition = MAX_POSITION_STEPS * extent / 65535.0f + POSITION_SLACK;
+		UCheck(results, measured.position <= maxPosition, mesh.name + " positions within half a quantization step");
+		UCheck(results, measured.normalDegrees <= MAX_NORMAL_DEGREES, mesh.name + " normals within " + std::to_string(MAX_NORMAL_DEGREES) + " degrees");
+		UCheck(results, measured.uv <= MAX_UV_ERROR, mesh.name + " texture coords within half float rounding");
+		UCheck(results, reported.position >= measured.position && reported.normalDegrees >= measured.normalDegrees && reported.uv >= measured.uv,
+			mesh.name + " packer reports at least the measured errors");
+
+		std::cout << "INFO: Packed " << mesh.name << ", max error: position " << measured.position << ", normal "
+			<< measured.normalDegrees << " degrees, uv " << measured.uv << std::endl;
+	}
+
+	// Octahedral encoding over the whole sphere, including the axes and the folded lower hemisphere
+	GLfloat worstNormal = 0.0f;
+	for (GLint latitude = -90; latitude <= 90; latitude += 3)
+	{
+		for (GLint longitude = 0; longitude < 360; longitude += 3)
+		{
+			GLfloat theta = glm::radians((GLfloat)latitude);
+			GLfloat phi = glm::radians((GLfloat)longitude);
+			glm::vec3 normal(std::cos(theta) * std::cos(phi), std::cos(theta) * std::sin(phi), std::sin(theta));
+			GLshort encoded[2];
+			UEncodeOctahedral(normal, encoded);
+			worstNormal = std::max(worstNormal, UDegreesBetween(glm::normalize(normal), UDecodeOctahedral(encoded)));
+		}
+	}
+	UCheck(results, worstNormal <= MAX_NORMAL_DEGREES, "octahedral normals within " + std::to_string(MAX_NORMAL_DEGREES) + " degrees over the sphere");
+
+	return results;
+}
@@ -0,0 +1,215 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "authoredmeshes.h"
+
+namespace
+{
+	// Plane vertex data
+	const GLfloat PLANE_VERTS[] = {
+		// Vertex Positions		// Normals			// Texture coords	// Index
+		5.0f, 5.0f, 5.0f,		0.0f, 1.0f, 0.0f,	1.0f, 0.0f,			//0
+		5.0f, 5.0f, -5.0f,		0.0f, 1.0f, 0.0f,	1.0f, 1.0f,			//1
+		-5.0f,  5.0f, 5.0f,		0.0f, 1.0f, 0.0f,	0.0f, 0.0f,			//2
+		-5.0f, 5.0f, -5.0f,		0.0f, 1.0f, 0.0f,	0.0f, 1.0f,			//3
+	};
+
+	// Index data to share position data
+	const GLuint PLANE_INDICES[] = {
+		0, 1, 2, //Triangle 1
+		3, 2, 1, //Triangle 2
+	};
+
+	// Cube position, normal and texture data
+	const GLfloat CUBE_VERTS[] = {
+		//Positions				//Normals
+		// ------------------------------------------------------
+
+		//Back Face				//Negative Z Normal  Texture Coords.
+		0.5f, 0.5f, -0.5f,		0.0f,  0.0f, -1.0f,  0.0f, 0.0f,   //0
+		0.5f, -0.5f, -0.5f,		0.0f,  0.0f, -1.0f,  0.0f, 0.0f,   //1
+		-0.5f, -0.5f, -0.5f,	0.0f,  0.0f, -1.0f,  0.0f, 0.0f,   //2
+		-0.5f, 0.5f, -0.5f,		0.0f,  0.0f, -1.0f,  0.0f, 0.0f,   //3
+
+		//Bottom Face			//Negative Y Normal
+		-0.5f, -0.5f, 0.5f,		0.0f, -1.0f,  0.0f,  0.0f, 1.0f,  //4
+		-0.5f, -0.5f, -0.5f,	0.0f, -1.0f,  0.0f,  0.0f, 0.0f,  //5
+		0.5f, -0.5f, -0.5f,		0.0f, -1.0f,  0.0f,  1.0f, 0.0f,  //6
+		0.5f, -0.5f,  0.5f,		0.0f, -1.0f,  0.0f,  1.0f, 1.0f, //7
+
+		//Left Face				//Negative X Normal
+		-0.5f, 0.5f, -0.5f,		1.0f,  0.0f,  0.0f,  0.0f, 0.0f,  //8
+		-0.5f, -0.5f,  -0.5f,	1.0f,  0.0f,  0.0f,  0.0f, 0.0f,  //9
+		-0.5f,  -0.5f,  0.5f,	1.0f,  0.0f,  0.0f,  0.0f, 0.0f,  //10
+		-0.5f,  0.5f,  0.5f,	1.0f,  0.0f,  0.0f,  0.0f, 0.0f,  //11
+
+		//Right Face			//Positive X Normal
+		0.5f,  0.5f,  0.5f,		1.0f,  0.0f,  0.0f,  0.0f, 0.0f,  //12
+		0.5f,  -0.5f, 0.5f,		1.0f,  0.0f,  0.0f,  0.0f, 0.0f,  //13
+		0.5f, -0.5f, -0.5f,		1.0f,  0.0f,  0.0f,  0.0f, 0.0f,  //14
+		0.5f, 0.5f, -0.5f,		1.0f,  0.0f,  0.0f,  0.0f, 0.0f,  //15
+
+		//Top Face				//Positive Y Normal
+		-0.5f,  0.5f, -0.5f,	0.0f,  1.0f,  0.0f,  1.0f, 0.0f, //16
+		-0.5f,  0.5f, 0.5f,		0.0f,  1.0f,  0.0f,  0.0f, 0.0f, //17
+		0.5f,  0.5f,  0.5f,		0.0f,  1.0f,  0.0f,  0.0f, 1.0f, //18
+		0.5f,  0.5f,  -0.5f,	0.0f,  1.0f,  0.0f,  1.0f, 1.0f, //19
+
+		//Front Face			//Positive Z Normal
+		-0.5f, 0.5f,  0.5f,	    0.0f,  0.0f,  1.0f,  0.0f, 0.0f, //20
+		-0.5f, -0.5f,  0.5f,	0.0f,  0.0f,  1.0f,  0.0f, 0.0f, //21
+		0.5f,  -0.5f,  0.5f,	0.0f,  0.0f,  1.0f,  0.0f, 0.0f, //22
+		0.5f,  0.5f,  0.5f,		0.0f,  0.0f,  1.0f,  0.0f, 0.0f, //23
+	};
+
+	// Index data
+	const GLuint CUBE_INDICES[] = {
+		0,1,2,
+		0,3,2,
+		4,5,6,
+		4,7,6,
+		8,9,10,
+		8,11,10,
+		12,13,14,
+		12,15,14,
+		16,17,18,
+		16,19,18,
+		20,21,22,
+		20,23,22
+	};
+
+	// Hexagon (coaster) position, normal and texture data
+	const GLfloat HEXAGON_VERTS[] = {
+		//Positions				//Normals
+		// ------------------------------------------------------
+		// Top Face				//Positive Y Normal    //Texture Coords.
+		// ------------------------------------------------------
+		-3.0f, 1.0f, 5.0f,		0.0f,  1.0f, 0.0f,     0.25f, 1.0f,   //0
+		-6.0f, 1.0f, 0.0f,		0.0f,  1.0f, 0.0f,     0.0f, 0.5f,   //1
+		-3.0f, 1.0f, -5.0f,		0.0f,  1.0f, 0.0f,     0.25f, 0.0f,   //2
+		3.0f, 1.0f, -5.0f,		0.0f,  1.0f, 0.0f,	   0.75f, 0.0f,   //3
+		6.0f, 1.0f, 0.0f,		0.0f,  1.0f, 0.0f,     1.0f, 0.5f,   //4
+		3.0f, 1.0f, 5.0f,		0.0f,  1.0f, 0.0f,     0.75f, 1.0f,   //5
+		0.0f, 1.0f, 0.0f,		0.0f,  1.0f, 0.0f,     0.5f, 0.5f,   //6
+
+		// Bottom Face			//Negative Y Normal     //Texture Coords.
+		// ------------------------------------------------------
+		-3.0f, 0.0f, 5.0f,		0.0f,  -1.0f, 0.0f,     0.25f, 1.0f,   //7
+		-6.0f, 0.0f, 0.0f,		0.0f,  -1.0f, 0.0f,     0.0f, 0.5f,   //8
+		-3.0f, 0.0f, -5.0f,		0.0f,  -1.0f, 0.0f,     0.25f, 0.0f,   //9
+		3.0f, 0.0f, -5.0f,		0.0f,  -1.0f, 0.0f,	    0.75f, 0.0f,   //10
+		6.0f, 0.0f, 0.0f,		0.0f,  -1.0f, 0.0f,     1.0f, 0.5f,   //11
+		3.0f, 0.0f, 5.0f,		0.0f,  -1.0f, 0.0f,     0.75f, 1.0f,   //12
+		0.0f, 0.0f, 0.0f,		0.0f,  -1.0f, 0.0f,     0.5f, 0.5f,   //13
+
+		//// Sides    			//Normal			    //Texture Coords.
+		// ------------------------------------------------------
+		-3.0f, 1.0f, 5.0f,		-1.0f, 0.0f, -1.0f,      0.0f, 0.5f,   //14
+		-6.0f, 1.0f, 0.0f,		-1.0f, 0.0f, -1.0f,      0.5f, 0.5f,   //15
+		-3.0f, 0.0f, 5.0f,		-1.0f, 0.0f, -1.0f,     0.0f, 0.0f,   //16
+		-6.0f, 1.0f, 0.0f,		-1.0f, 0.0f, -1.0f,      0.5f, 0.5f,   //17
+		-3.0f, 0.0f, 5.0f,		-1.0f, 0.0f, -1.0f,     0.0f, 0.0f,   //18
+		-6.0f, 0.0f, 0.0f,		-1.0f, 0.0f, -1.0f,     0.5f, 0.0f,   //19
+
+		-6.0f, 1.0f, 0.0f,		-1.0f, 0.0f, 1.0f,     0.0f, 0.5f,  //20
+		-3.0f, 1.0f, -5.0f,		-1.0f, 0.0f, 1.0f,     0.5f, 0.5f,    //21
+		-6.0f, 0.0f, 0.0f,		-1.0f, 0.0f, 1.0f,     0.0f, 0.0f,   //22
+		-3.0f, 1.0f, -5.0f,		-1.0f, 0.0f, 1.0f,     0.5f, 0.5f,   //23
+		-6.0f, 0.0f, 0.0f,		-1.0f, 0.0f, 1.0f,     0.0f, 0.0f,   //24
+		-3.0f, 0.0f, -5.0f,		-1.0f, 0.0f, 1.0f,     0.5f, 0.0f,   //25
+
+		-3.0f, 1.0f, -5.0f,		0.0f, 0.0f, 1.0f,     0.0f, 0.5f,   //26
+		3.0f, 1.0f, -5.0f,		0.0f, 0.0f, 1.0f,	   0.5f, 0.5f,   //27
+		-3.0f, 0.0f, -5.0f,		0.0f, 0.0f, 1.0f,     0.0f, 0.0f,   //28
+		3.0f, 1.0f, -5.0f,		0.0f, 0.0f, 1.0f,	   0.5f, 0.5f,   //29
+		-3.0f, 0.0f, -5.0f,		0.0f, 0.0f, 1.0f,     0.0f, 0.0f,   //30
+		3.0f, 0.0f, -5.0f,		0.0f, 0.0f, 1.0f,	  0.5f, 0.0f,   //31
+
+		3.0f, 1.0f, -5.0f,		1.0f, 0.0f, 1.0f,	   0.0f, 0.5f,   //32
+		6.0f, 1.0f, 0.0f,		1.0f, 0.0f, 1.0f,     0.5f, 0.5f,   //33
+		3.0f, 0.0f, -5.0f,		1.0f, 0.0f, 1.0f,	   0.0f, 0.0f,   //34
+		6.0f, 1.0f, 0.0f,		1.0f, 0.0f, 1.0f,     0.5f, 0.5f,   //35
+		3.0f, 0.0f, -5.0f,		1.0f, 0.0f, 1.0f,	   0.0f, 0.0f,   //36
+		6.0f, 0.0f, 0.0f,		1.0f, 0.0f, 1.0f,     0.5f, 0.0f,   //37
+
+		6.0f, 1.0f, 0.0f,		1.0f, 0.0f, -1.0f,     0.0f, 0.5f,   //38
+		3.0f, 1.0f, 5.0f,		1.0f, 0.0f, -1.0f,     0.5f, 0.5f,   //39
+		3.0f, 0.0f, 5.0f,		1.0f, 0.0f, -1.0f,     0.0f, 0.0f,   //40
+		6.0f, 1.0f, 0.0f,		1.0f, 0.0f, -1.0f,     0.5f, 0.5f,   //41
+		6.0f, 0.0f, 0.0f,		1.0f, 0.0f, -1.0f,     0.0f, 0.0f,   //42
+		3.0f, 0.0f, 5.0f,		1.0f, 0.0f, -1.0f,     0.5f, 0.0f,   //43
+
+		-3.0f, 1.0f, 5.0f,		0.0f, 0.0f, -1.0f,     0.0f, 0.5f,   //44
+		3.0f, 1.0f, 5.0f,		0.0f, 0.0f, -1.0f,     0.5f, 0.5f,   //45
+		-3.0f, 0.0f, 5.0f,		0.0f, 0.0f, -1.0f,     0.0f, 0.0f,   //46
+		3.0f, 1.0f, 5.0f,		0.0f, 0.0f, -1.0f,     0.5f, 0.5f,   //47
+		-3.0f, 0.0f, 5.0f,		0.0f, 0.0f, -1.0f,     0.0f, 0.0f,   //48
+		3.0f, 0.0f, 5.0f,		0.0f, 0.0f, -1.0f,     0.5f, 0.0f,   //49
+	};
+
+	// Index data
+	const GLuint HEXAGON_INDICES[] = {
+		0,1,6,
+		1,2,6,
+		2,3,6,
+		3,4,6,
+		4,5,6,
+		0,5,6,
+
+		7,8,13,
+		8,9,13,
+		9,10,13,
+		10,11,13,
+		11,12,13,
+		7,12,13,
+
+		14,15,16,
+		17,18,19,
+		20,21,22,
+		23,24,25,
+		26,27,28,
+		29,30,31,
+		32,33,34,
+		35,36,37,
+		38,39,40,
+		41,42,43,
+		44,45,46,
+		47,48,49
+	};
+}
+
+
+AuthoredMesh UAuthoredPlane()
+{
+	AuthoredMesh mesh;
+	mesh.verts = PLANE_VERTS;
+	mesh.nVertices = sizeof(PLANE_VERTS) / (sizeof(PLANE_VERTS[0]) * PRIMITIVE_FLOATS_PER_VERTEX);
+	mesh.indices = PLANE_INDICES;
+	mesh.nIndices = sizeof(PLANE_INDICES) / sizeof(PLANE_INDICES[0]);
+	return mesh;
+}
+
+
+AuthoredMesh UAuthoredCube()
+{
+	AuthoredMesh mesh;
+	mesh.verts = CUBE_VERTS;
+	mesh.nVertices = sizeof(CUBE_VERTS) / (sizeof(CUBE_VERTS[0]) * PRIMITIVE_FLOATS_PER_VERTEX);
+	mesh.indices = CUBE_INDICES;
+	mesh.nIndices = sizeof(CUBE_INDICES) / sizeof(CUBE_INDICES[0]);
+	return mesh;
+}
+
+
+AuthoredMesh UAuthoredHexagon()
+{
+	AuthoredMesh mesh;
+	mesh.verts = HEXAGON_VERTS;
+	mesh.nVertices = sizeof(HEXAGON_VERTS) / (sizeof(HEXAGON_VERTS[0]) * PRIMITIVE_FLOATS_PER_VERTEX);
+	mesh.indices = HEXAGON_INDICES;
+	mesh.nIndices = sizeof(HEXAGON_INDICES) / sizeof(HEXAGON_INDICES[0]);
+	return mesh;
+}
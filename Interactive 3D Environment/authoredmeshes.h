@@ -0,0 +1,27 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include "primitives.h"
+
+// A hand-written mesh: interleaved vertices laid out like the generated primitives, and triangle list indices
+struct AuthoredMesh
+{
+	const GLfloat* verts;
+	GLuint nVertices;
+	const GLuint* indices;
+	GLuint nIndices;
+};
+
+/* The meshes that are typed out rather than generated. The data is static and makes no GL calls,
+ * so the CPU tests can run it through the same welding and optimization as Meshes.
+ */
+AuthoredMesh UAuthoredPlane();
+AuthoredMesh UAuthoredCube();
+AuthoredMesh UAuthoredHexagon();
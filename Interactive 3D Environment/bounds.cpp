@@ -0,0 +1,145 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "bounds.h"
+#include "primitives.h"
+
+#include <algorithm>
+#include <cmath>
+
+// SSE2 is part of every x64 target, 32 bit builds fall back to scalar code without /arch:SSE2
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BOUNDS_USE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+#ifdef BOUNDS_USE_SSE
+	// Loads a 4 x 3 matrix column (w ignored)
+	__m128 ULoadColumn(const glm::mat4& m, int column)
+	{
+		return _mm_setr_ps(m[column][0], m[column][1], m[column][2], 0.0f);
+	}
+
+	__m128 UAbs(__m128 v)
+	{
+		return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+	}
+
+	glm::vec3 UStore(__m128 v)
+	{
+		float lanes[4];
+		_mm_storeu_ps(lanes, v);
+		return glm::vec3(lanes[0], lanes[1], lanes[2]);
+	}
+#endif
+}
+
+
+void UComputeBounds(const GLfloat* verts, GLuint nVertices, BoundingBox& box, BoundingSphere& sphere)
+{
+	if (nVertices == 0)
+	{
+		box.lower = box.upper = sphere.center = glm::vec3(0.0f);
+		sphere.radius = 0.0f;
+		return;
+	}
+
+#ifdef BOUNDS_USE_SSE
+	// One vertex per iteration, the fourth lane (the normal's x) is dropped on store
+	__m128 lower = _mm_loadu_ps(verts);
+	__m128 upper = lower;
+	for (GLuint v = 1; v < nVertices; ++v)
+	{
+		__m128 position = _mm_loadu_ps(verts + v * PRIMITIVE_FLOATS_PER_VERTEX);
+		lower = _mm_min_ps(lower, position);
+		upper = _mm_max_ps(upper, position);
+	}
+	box.lower = UStore(lower);
+	box.upper = UStore(upper);
+
+	__m128 center = _mm_mul_ps(_mm_add_ps(lower, upper), _mm_set1_ps(0.5f));
+	const __m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	__m128 farthest = _mm_setzero_ps();
+	for (GLuint v = 0; v < nVertices; ++v)
+	{
+		__m128 offset = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(verts + v * PRIMITIVE_FLOATS_PER_VERTEX), center), xyz);
+		__m128 squared = _mm_mul_ps(offset, offset);
+		// Horizontal add of x, y and z
+		squared = _mm_add_ps(squared, _mm_movehl_ps(squared, squared));
+		squared = _mm_add_ss(squared, _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(1, 1, 1, 1)));
+		farthest = _mm_max_ss(farthest, squared);
+	}
+	sphere.center = UStore(center);
+	sphere.radius = std::sqrt(_mm_cvtss_f32(farthest));
+#else
+	box.lower = glm::vec3(verts[0], verts[1], verts[2]);
+	box.upper = box.lower;
+	for (GLuint v = 1; v < nVertices; ++v)
+	{
+		glm::vec3 position(verts[v * PRIMITIVE_FLOATS_PER_VERTEX], verts[v * PRIMITIVE_FLOATS_PER_VERTEX + 1], verts[v * PRIMITIVE_FLOATS_PER_VERTEX + 2]);
+		box.lower = glm::min(box.lower, position);
+		box.upper = glm::max(box.upper, position);
+	}
+
+	sphere.center = (box.lower + box.upper) * 0.5f;
+	GLfloat farthest = 0.0f;
+	for (GLuint v = 0; v < nVertices; ++v)
+	{
+		glm::vec3 position(verts[v * PRIMITIVE_FLOATS_PER_VERTEX], verts[v * PRIMITIVE_FLOATS_PER_VERTEX + 1], verts[v * PRIMITIVE_FLOATS_PER_VERTEX + 2]);
+		glm::vec3 offset = position - sphere.center;
+		farthest = std::max(farthest, glm::dot(offset, offset));
+	}
+	sphere.radius = std::sqrt(farthest);
+#endif
+}
+
+
+BoundingBox UTransformBox(const BoundingBox& box, const glm::mat4& model)
+{
+	// Arvo: transform the center, the new half extents are |M| times the old ones
+	BoundingBox result;
+#ifdef BOUNDS_USE_SSE
+	__m128 column0 = ULoadColumn(model, 0);
+	__m128 column1 = ULoadColumn(model, 1);
+	__m128 column2 = ULoadColumn(model, 2);
+	__m128 translation = ULoadColumn(model, 3);
+
+	glm::vec3 c = (box.lower + box.upper) * 0.5f;
+	glm::vec3 e = (box.upper - box.lower) * 0.5f;
+
+	__m128 center = _mm_add_ps(translation, _mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(c.x)),
+		_mm_add_ps(_mm_mul_ps(column1, _mm_set1_ps(c.y)), _mm_mul_ps(column2, _mm_set1_ps(c.z)))));
+	__m128 extent = _mm_add_ps(_mm_mul_ps(UAbs(column0), _mm_set1_ps(e.x)),
+		_mm_add_ps(_mm_mul_ps(UAbs(column1), _mm_set1_ps(e.y)), _mm_mul_ps(UAbs(column2), _mm_set1_ps(e.z))));
+
+	result.lower = UStore(_mm_sub_ps(center, extent));
+	result.upper = UStore(_mm_add_ps(center, extent));
+#else
+	glm::vec3 c = (box.lower + box.upper) * 0.5f;
+	glm::vec3 e = (box.upper - box.lower) * 0.5f;
+	glm::vec3 center = glm::vec3(model * glm::vec4(c, 1.0f));
+	glm::vec3 extent = glm::abs(glm::vec3(model[0])) * e.x + glm::abs(glm::vec3(model[1])) * e.y + glm::abs(glm::vec3(model[2])) * e.z;
+
+	result.lower = center - extent;
+	result.upper = center + extent;
+#endif
+	return result;
+}
+
+
+BoundingSphere UTransformSphere(const BoundingSphere& sphere, const glm::mat4& model)
+{
+	BoundingSphere result;
+	result.center = glm::vec3(model * glm::vec4(sphere.center, 1.0f));
+
+	// Rotation keeps lengths, so the longest scaled axis bounds the growth
+	GLfloat scale = std::max(glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+		std::max(glm::dot(glm::vec3(model[1]), glm::vec3(model[1])), glm::dot(glm::vec3(model[2]), glm::vec3(model[2]))));
+	result.radius = sphere.radius * std::sqrt(scale);
+	return result;
+}
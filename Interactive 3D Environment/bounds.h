@@ -0,0 +1,35 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+// Axis aligned bounding box
+struct BoundingBox
+{
+	glm::vec3 lower;
+	glm::vec3 upper;
+};
+
+struct BoundingSphere
+{
+	glm::vec3 center;
+	GLfloat radius;
+};
+
+/* Bounds of interleaved vertices (PRIMITIVE_FLOATS_PER_VERTEX floats each, position first).
+ * The sphere is centered on the box and just reaches the farthest vertex.
+ */
+void UComputeBounds(const GLfloat* verts, GLuint nVertices, BoundingBox& box, BoundingSphere& sphere);
+
+/* Bounds after a model matrix, such as the translation * rotation * scale built by URender.
+ * The box is the tightest axis aligned box around the transformed box; the sphere grows with the largest axis scale.
+ */
+BoundingBox UTransformBox(const BoundingBox& box, const glm::mat4& model);
+BoundingSphere UTransformSphere(const BoundingSphere& sphere, const glm::mat4& model);
@@ -0,0 +1,57 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "frameblock.h"
+
+#include <iostream>
+
+bool UCreateFrameBlock(GLuint& bufferId)
+{
+	glGenBuffers(1, &bufferId);
+	if (bufferId == 0)
+	{
+		std::cout << "ERROR: Could not create the frame uniform buffer" << std::endl;
+		return false;
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, bufferId);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameBlock), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	return true;
+}
+
+
+void UDestroyFrameBlock(GLuint bufferId)
+{
+	glDeleteBuffers(1, &bufferId);
+}
+
+
+bool UCheckFrameBlock(GLuint programId)
+{
+	GLuint blockIndex = glGetUniformBlockIndex(programId, "FrameBlock");
+	if (blockIndex == GL_INVALID_INDEX)
+		return true;
+
+	GLint blockSize = 0;
+	glGetActiveUniformBlockiv(programId, blockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &blockSize);
+	if (blockSize != (GLint)sizeof(FrameBlock))
+	{
+		std::cout << "ERROR: FrameBlock of program " << programId << " is " << blockSize << " bytes, expected " << sizeof(FrameBlock) << std::endl;
+		return false;
+	}
+
+	// Same binding the shader declares, kept explicit for drivers that ignore the qualifier
+	glUniformBlockBinding(programId, blockIndex, FRAME_BLOCK_BINDING);
+	return true;
+}
+
+
+void UUpdateFrameBlock(GLuint bufferId, const FrameBlock& block)
+{
+	glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, bufferId);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameBlock), &block);
+}
@@ -0,0 +1,61 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+// Uniform buffer binding point of the per-frame block, matches binding = 0 in the shaders
+const GLuint FRAME_BLOCK_BINDING = 0;
+
+/* Camera and lighting data shared by every program, laid out like the std140 block
+ *
+ *   layout(std140, binding = 0) uniform FrameBlock
+ *   {
+ *       mat4 view;
+ *       mat4 projection;
+ *       vec3 viewPosition;
+ *       vec3 lightColor;
+ *       vec3 lightPos;
+ *       vec3 windowLightColor;
+ *       vec3 windowLightPos;
+ *   };
+ *
+ * std140 aligns a vec3 to 16 bytes, so each one is stored as a vec4 whose w is unused.
+ */
+struct FrameBlock
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec4 viewPosition;
+	glm::vec4 lightColor;
+	glm::vec4 lightPos;
+	glm::vec4 windowLightColor;
+	glm::vec4 windowLightPos;
+};
+
+static_assert(offsetof(FrameBlock, view) == 0, "FrameBlock does not match the std140 layout");
+static_assert(offsetof(FrameBlock, projection) == 64, "FrameBlock does not match the std140 layout");
+static_assert(offsetof(FrameBlock, viewPosition) == 128, "FrameBlock does not match the std140 layout");
+static_assert(offsetof(FrameBlock, lightColor) == 144, "FrameBlock does not match the std140 layout");
+static_assert(offsetof(FrameBlock, lightPos) == 160, "FrameBlock does not match the std140 layout");
+static_assert(offsetof(FrameBlock, windowLightColor) == 176, "FrameBlock does not match the std140 layout");
+static_assert(offsetof(FrameBlock, windowLightPos) == 192, "FrameBlock does not match the std140 layout");
+static_assert(sizeof(FrameBlock) == 208, "FrameBlock does not match the std140 layout");
+
+// Creates the uniform buffer holding one FrameBlock
+bool UCreateFrameBlock(GLuint& bufferId);
+void UDestroyFrameBlock(GLuint bufferId);
+
+// Checks that a program declaring FrameBlock agrees on its size; programs without the block pass
+bool UCheckFrameBlock(GLuint programId);
+
+// Writes the whole block with one buffer update and binds it for every program
+void UUpdateFrameBlock(GLuint bufferId, const FrameBlock& block);
@@ -0,0 +1,288 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "frustum.h"
+
+#include <cmath>
+
+// SSE2 is part of every x64 target, 32 bit builds fall back to scalar code without /arch:SSE2.
+// The AVX path is compiled on every x86 build and picked at run time, so it needs no /arch:AVX flag.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_USE_SSE
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#define FRUSTUM_USE_AVX
+#define FRUSTUM_AVX_TARGET
+#include <intrin.h>
+#elif defined(__GNUC__)
+#define FRUSTUM_USE_AVX
+#define FRUSTUM_AVX_TARGET __attribute__((target("avx")))
+#include <cpuid.h>
+#endif
+#endif
+
+namespace
+{
+	const GLuint FRUSTUM_PLANES = 6;
+
+	/* One object of the arrays against every plane, in the same operation order as the SIMD paths
+	 * so both reach the same answer for bounds touching a plane.
+	 */
+	bool UIsVisible(const Frustum& frustum, const CullBounds& bounds, GLuint i)
+	{
+		for (GLuint p = 0; p < FRUSTUM_PLANES; ++p)
+		{
+			const glm::vec4& plane = frustum.planes[p];
+			GLfloat sphereDistance = plane.x * bounds.gSphereX[i] + plane.y * bounds.gSphereY[i] + plane.z * bounds.gSphereZ[i] + plane.w;
+			if (sphereDistance < -bounds.gRadius[i])
+				return false;
+
+			// Distance of the box corner farthest along the plane normal
+			GLfloat boxDistance = plane.x * bounds.gBoxX[i] + plane.y * bounds.gBoxY[i] + plane.z * bounds.gBoxZ[i] + plane.w;
+			GLfloat boxReach = std::fabs(plane.x) * bounds.gExtentX[i] + std::fabs(plane.y) * bounds.gExtentY[i] + std::fabs(plane.z) * bounds.gExtentZ[i];
+			if (boxDistance < -boxReach)
+				return false;
+		}
+		return true;
+	}
+
+#ifdef FRUSTUM_USE_AVX
+	// CPU and OS both support AVX: cpuid reports it and XGETBV shows the OS saves the ymm registers
+	bool UDetectAvx()
+	{
+		int info[4] = { 0, 0, 0, 0 };
+#if defined(_MSC_VER) && !defined(__clang__)
+		__cpuid(info, 1);
+#else
+		unsigned int eax, ebx, ecx, edx;
+		if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+			return false;
+		info[2] = (int)ecx;
+#endif
+		const int osxsave = 1 << 27;
+		const int avx = 1 << 28;
+		if ((info[2] & (osxsave | avx)) != (osxsave | avx))
+			return false;
+
+#if defined(_MSC_VER) && !defined(__clang__)
+		unsigned long long xcr0 = _xgetbv(0);
+#else
+		unsigned int xcr0Low, xcr0High;
+		__asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+		unsigned long long xcr0 = xcr0Low;
+#endif
+		// xmm and ymm state
+		return (xcr0 & 6) == 6;
+	}
+
+	bool UHasAvx()
+	{
+		static const bool hasAvx = UDetectAvx();
+		return hasAvx;
+	}
+
+	// Eight objects per iteration from i on; returns the first object left for narrower paths
+	FRUSTUM_AVX_TARGET GLuint UCullAvx(const Frustum& frustum, const CullBounds& bounds, GLuint i, GLuint end, unsigned char* visible, GLuint& nVisible)
+	{
+		const __m256 signBit = _mm256_set1_ps(-0.0f);
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 sphereX = _mm256_loadu_ps(&bounds.gSphereX[i]);
+			__m256 sphereY = _mm256_loadu_ps(&bounds.gSphereY[i]);
+			__m256 sphereZ = _mm256_loadu_ps(&bounds.gSphereZ[i]);
+			__m256 negativeRadius = _mm256_xor_ps(_mm256_loadu_ps(&bounds.gRadius[i]), signBit);
+			__m256 boxX = _mm256_loadu_ps(&bounds.gBoxX[i]);
+			__m256 boxY = _mm256_loadu_ps(&bounds.gBoxY[i]);
+			__m256 boxZ = _mm256_loadu_ps(&bounds.gBoxZ[i]);
+			__m256 extentX = _mm256_loadu_ps(&bounds.gExtentX[i]);
+			__m256 extentY = _mm256_loadu_ps(&bounds.gExtentY[i]);
+			__m256 extentZ = _mm256_loadu_ps(&bounds.gExtentZ[i]);
+
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (GLuint p = 0; p < FRUSTUM_PLANES; ++p)
+			{
+				const glm::vec4& plane = frustum.planes[p];
+				__m256 x = _mm256_set1_ps(plane.x);
+				__m256 y = _mm256_set1_ps(plane.y);
+				__m256 z = _mm256_set1_ps(plane.z);
+				__m256 w = _mm256_set1_ps(plane.w);
+
+				__m256 sphereDistance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, sphereX), _mm256_mul_ps(y, sphereY)), _mm256_mul_ps(z, sphereZ)), w);
+				// Not less than, like the scalar test, so NaN bounds stay visible
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(sphereDistance, negativeRadius, _CMP_NLT_UQ));
+
+				__m256 boxDistance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, boxX), _mm256_mul_ps(y, boxY)), _mm256_mul_ps(z, boxZ)), w);
+				__m256 boxReach = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_andnot_ps(signBit, x), extentX),
+					_mm256_mul_ps(_mm256_andnot_ps(signBit, y), extentY)), _mm256_mul_ps(_mm256_andnot_ps(signBit, z), extentZ));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(boxDistance, _mm256_xor_ps(boxReach, signBit), _CMP_NLT_UQ));
+			}
+
+			int mask = _mm256_movemask_ps(inside);
+			for (GLuint lane = 0; lane < 8; ++lane)
+			{
+				visible[i + lane] = (mask >> lane) & 1;
+				nVisible += visible[i + lane];
+			}
+		}
+		return i;
+	}
+#endif
+
+#ifdef FRUSTUM_USE_SSE
+	// Four objects per iteration from i on; returns the first object left for the scalar test
+	GLuint UCullSse(const Frustum& frustum, const CullBounds& bounds, GLuint i, GLuint end, unsigned char* visible, GLuint& nVisible)
+	{
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 sphereX = _mm_loadu_ps(&bounds.gSphereX[i]);
+			__m128 sphereY = _mm_loadu_ps(&bounds.gSphereY[i]);
+			__m128 sphereZ = _mm_loadu_ps(&bounds.gSphereZ[i]);
+			__m128 negativeRadius = _mm_xor_ps(_mm_loadu_ps(&bounds.gRadius[i]), signBit);
+			__m128 boxX = _mm_loadu_ps(&bounds.gBoxX[i]);
+			__m128 boxY = _mm_loadu_ps(&bounds.gBoxY[i]);
+			__m128 boxZ = _mm_loadu_ps(&bounds.gBoxZ[i]);
+			__m128 extentX = _mm_loadu_ps(&bounds.gExtentX[i]);
+			__m128 extentY = _mm_loadu_ps(&bounds.gExtentY[i]);
+			__m128 extentZ = _mm_loadu_ps(&bounds.gExtentZ[i]);
+
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (GLuint p = 0; p < FRUSTUM_PLANES; ++p)
+			{
+				const glm::vec4& plane = frustum.planes[p];
+				__m128 x = _mm_set1_ps(plane.x);
+				__m128 y = _mm_set1_ps(plane.y);
+				__m128 z = _mm_set1_ps(plane.z);
+				__m128 w = _mm_set1_ps(plane.w);
+
+				__m128 sphereDistance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, sphereX), _mm_mul_ps(y, sphereY)), _mm_mul_ps(z, sphereZ)), w);
+				// Not less than, like the scalar test, so NaN bounds stay visible
+				inside = _mm_and_ps(inside, _mm_cmpnlt_ps(sphereDistance, negativeRadius));
+
+				__m128 boxDistance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, boxX), _mm_mul_ps(y, boxY)), _mm_mul_ps(z, boxZ)), w);
+				__m128 boxReach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signBit, x), extentX),
+					_mm_mul_ps(_mm_andnot_ps(signBit, y), extentY)), _mm_mul_ps(_mm_andnot_ps(signBit, z), extentZ));
+				inside = _mm_and_ps(inside, _mm_cmpnlt_ps(boxDistance, _mm_xor_ps(boxReach, signBit)));
+			}
+
+			int mask = _mm_movemask_ps(inside);
+			for (GLuint lane = 0; lane < 4; ++lane)
+			{
+				visible[i + lane] = (mask >> lane) & 1;
+				nVisible += visible[i + lane];
+			}
+		}
+		return i;
+	}
+#endif
+}
+
+
+Frustum UExtractFrustum(const glm::mat4& viewProjection)
+{
+	// Rows of the matrix; glm stores columns
+	glm::vec4 rows[4];
+	for (GLuint r = 0; r < 4; ++r)
+		rows[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+
+	// Clip space keeps -w <= x, y, z <= w
+	Frustum frustum;
+	frustum.planes[0] = rows[3] + rows[0];
+	frustum.planes[1] = rows[3] - rows[0];
+	frustum.planes[2] = rows[3] + rows[1];
+	frustum.planes[3] = rows[3] - rows[1];
+	frustum.planes[4] = rows[3] + rows[2];
+	frustum.planes[5] = rows[3] - rows[2];
+
+	for (glm::vec4& plane : frustum.planes)
+		plane /= glm::length(glm::vec3(plane));
+	return frustum;
+}
+
+
+Frustum UUnboundedFrustum()
+{
+	// No normal, every point is one unit inside each plane
+	Frustum frustum;
+	for (glm::vec4& plane : frustum.planes)
+		plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	return frustum;
+}
+
+
+void CullBounds::Resize(GLuint nObjects)
+{
+	for (std::vector<GLfloat>* field : { &gBoxX, &gBoxY, &gBoxZ, &gExtentX, &gExtentY, &gExtentZ, &gSphereX, &gSphereY, &gSphereZ, &gRadius })
+		field->resize(nObjects);
+}
+
+
+void CullBounds::Set(GLuint object, const BoundingBox& box, const BoundingSphere& sphere)
+{
+	glm::vec3 center = (box.lower + box.upper) * 0.5f;
+	glm::vec3 extent = (box.upper - box.lower) * 0.5f;
+	gBoxX[object] = center.x;
+	gBoxY[object] = center.y;
+	gBoxZ[object] = center.z;
+	gExtentX[object] = extent.x;
+	gExtentY[object] = extent.y;
+	gExtentZ[object] = extent.z;
+	gSphereX[object] = sphere.center.x;
+	gSphereY[object] = sphere.center.y;
+	gSphereZ[object] = sphere.center.z;
+	gRadius[object] = sphere.radius;
+}
+
+
+GLuint CullBounds::Size() const
+{
+	return (GLuint)gRadius.size();
+}
+
+
+bool UIsVisible(const Frustum& frustum, const BoundingBox& box, const BoundingSphere& sphere)
+{
+	glm::vec3 center = (box.lower + box.upper) * 0.5f;
+	glm::vec3 extent = (box.upper - box.lower) * 0.5f;
+	for (const glm::vec4& plane : frustum.planes)
+	{
+		if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius)
+			return false;
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -glm::dot(glm::abs(glm::vec3(plane)), extent))
+			return false;
+	}
+	return true;
+}
+
+
+GLuint UCullBounds(const Frustum& frustum, const CullBounds& bounds, std::vector<unsigned char>& visible)
+{
+	visible.resize(bounds.Size());
+	return UCullBounds(frustum, bounds, 0, bounds.Size(), visible.data());
+}
+
+
+GLuint UCullBounds(const Frustum& frustum, const CullBounds& bounds, GLuint first, GLuint end, unsigned char* visible)
+{
+	GLuint nVisible = 0;
+	GLuint i = first;
+
+#ifdef FRUSTUM_USE_AVX
+	if (UHasAvx())
+		i = UCullAvx(frustum, bounds, i, end, visible, nVisible);
+#endif
+#ifdef FRUSTUM_USE_SSE
+	i = UCullSse(frustum, bounds, i, end, visible, nVisible);
+#endif
+
+	// Objects left over from the SIMD batches, or all of them in scalar builds
+	for (; i < end; ++i)
+	{
+		visible[i] = UIsVisible(frustum, bounds, i);
+		nVisible += visible[i];
+	}
+	return nVisible;
+}
@@ -0,0 +1,58 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "bounds.h"
+
+// Left, right, bottom, top, near and far planes; a point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0
+struct Frustum
+{
+	glm::vec4 planes[6];
+};
+
+/* Planes of the clip volume of a projection * view matrix, normalized so plane distances are in world units.
+ * Works for the perspective and orthographic projections alike.
+ */
+Frustum UExtractFrustum(const glm::mat4& viewProjection);
+
+// Frustum every bound is inside of, for drawing without culling
+Frustum UUnboundedFrustum();
+
+/* World bounds of many objects as a structure of arrays, so one SIMD register holds the same field of 4 or 8 objects.
+ * Boxes are kept as center and half extent, spheres as center and radius.
+ */
+class CullBounds
+{
+public:
+	std::vector<GLfloat> gBoxX, gBoxY, gBoxZ;
+	std::vector<GLfloat> gExtentX, gExtentY, gExtentZ;
+	std::vector<GLfloat> gSphereX, gSphereY, gSphereZ;
+	std::vector<GLfloat> gRadius;
+
+public:
+	void Resize(GLuint nObjects);
+	void Set(GLuint object, const BoundingBox& box, const BoundingSphere& sphere);
+	GLuint Size() const;
+};
+
+/* Reference test: an object is culled when its sphere or its box lies entirely behind one plane.
+ * Both are conservative, so an object passing both may still be out of view near the frustum corners.
+ */
+bool UIsVisible(const Frustum& frustum, const BoundingBox& box, const BoundingSphere& sphere);
+
+/* Same test for every object, eight at a time on CPUs with AVX, four with SSE, or one by one in scalar builds.
+ * Sets visible[i] to 1 or 0 and returns the number of visible objects.
+ */
+GLuint UCullBounds(const Frustum& frustum, const CullBounds& bounds, std::vector<unsigned char>& visible);
+// Same for the objects first to end - 1, writing visible[first] to visible[end - 1]; ranges may be culled on separate threads
+GLuint UCullBounds(const Frustum& frustum, const CullBounds& bounds, GLuint first, GLuint end, unsigned char* visible);
@@ -0,0 +1,168 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "glstate.h"
+
+GLState::GLState()
+{
+	Invalidate();
+	ResetCounters();
+}
+
+
+void GLState::UseProgram(GLuint program)
+{
+	if (UIssue(gProgramKnown && gProgram == program))
+	{
+		glUseProgram(program);
+		gProgram = program;
+		gProgramKnown = true;
+	}
+}
+
+
+void GLState::BindVertexArray(GLuint vao)
+{
+	if (UIssue(gVaoKnown && gVao == vao))
+	{
+		glBindVertexArray(vao);
+		gVao = vao;
+		gVaoKnown = true;
+	}
+}
+
+
+void GLState::ActiveTexture(GLenum unit)
+{
+	GLuint index = unit - GL_TEXTURE0;
+	if (UIssue(gUnitKnown && gUnit == index))
+	{
+		glActiveTexture(unit);
+		gUnit = index;
+		gUnitKnown = true;
+	}
+}
+
+
+void GLState::BindTexture(GLenum target, GLuint texture)
+{
+	// Untracked targets and units, or an unknown active unit, always go through
+	bool tracked = gUnitKnown && gUnit < MAX_TEXTURE_UNITS && (target == GL_TEXTURE_2D || target == GL_TEXTURE_2D_ARRAY);
+	bool* known = nullptr;
+	GLuint* bound = nullptr;
+	if (tracked)
+	{
+		known = target == GL_TEXTURE_2D ? &gTexture2DKnown[gUnit] : &gTextureArrayKnown[gUnit];
+		bound = target == GL_TEXTURE_2D ? &gTexture2D[gUnit] : &gTextureArray[gUnit];
+	}
+
+	if (UIssue(tracked && *known && *bound == texture))
+	{
+		glBindTexture(target, texture);
+		if (tracked)
+		{
+			*bound = texture;
+			*known = true;
+		}
+	}
+}
+
+
+void GLState::Enable(GLenum capability)
+{
+	USetCapability(capability, true);
+}
+
+
+void GLState::Disable(GLenum capability)
+{
+	USetCapability(capability, false);
+}
+
+
+void GLState::ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+	glm::vec4 color(red, green, blue, alpha);
+	if (UIssue(gClearColorKnown && gClearColor == color))
+	{
+		glClearColor(red, green, blue, alpha);
+		gClearColor = color;
+		gClearColorKnown = true;
+	}
+}
+
+
+void GLState::Invalidate()
+{
+	gProgramKnown = false;
+	gVaoKnown = false;
+	gUnitKnown = false;
+	for (GLuint unit = 0; unit < MAX_TEXTURE_UNITS; ++unit)
+	{
+		gTexture2DKnown[unit] = false;
+		gTextureArrayKnown[unit] = false;
+	}
+	for (GLuint capability = 0; capability < CAPABILITY_COUNT; ++capability)
+		gCapabilityKnown[capability] = false;
+	gClearColorKnown = false;
+}
+
+
+void GLState::ResetCounters()
+{
+	gIssued = 0;
+	gFiltered = 0;
+}
+
+
+GLState::TrackedCapability GLState::UTrack(GLenum capability)
+{
+	switch (capability)
+	{
+	case GL_DEPTH_TEST:
+		return CAPABILITY_DEPTH_TEST;
+	case GL_CULL_FACE:
+		return CAPABILITY_CULL_FACE;
+	case GL_BLEND:
+		return CAPABILITY_BLEND;
+	case GL_STENCIL_TEST:
+		return CAPABILITY_STENCIL_TEST;
+	case GL_SCISSOR_TEST:
+		return CAPABILITY_SCISSOR_TEST;
+	default:
+		return CAPABILITY_UNTRACKED;
+	}
+}
+
+
+void GLState::USetCapability(GLenum capability, bool enabled)
+{
+	TrackedCapability tracked = UTrack(capability);
+	bool redundant = tracked != CAPABILITY_UNTRACKED && gCapabilityKnown[tracked] && gCapability[tracked] == enabled;
+	if (!UIssue(redundant))
+		return;
+
+	if (enabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+
+	if (tracked != CAPABILITY_UNTRACKED)
+	{
+		gCapability[tracked] = enabled;
+		gCapabilityKnown[tracked] = true;
+	}
+}
+
+
+bool GLState::UIssue(bool redundant)
+{
+	if (redundant)
+		++gFiltered;
+	else
+		++gIssued;
+	return !redundant;
+}
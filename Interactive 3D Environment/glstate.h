@@ -0,0 +1,75 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+/* Shadow copy of the GL state the render loops touch; calls that would not change it never reach the driver.
+ * Until a value is first set through the cache it is unknown and the call always goes through.
+ * Code binding state directly (object creation, for instance) must call Invalidate before the cache is used again.
+ */
+class GLState
+{
+public:
+	static const GLuint MAX_TEXTURE_UNITS = 16;
+
+	// Calls forwarded to GL and calls dropped as redundant since the last ResetCounters
+	GLuint gIssued;
+	GLuint gFiltered;
+
+public:
+	GLState();
+
+	void UseProgram(GLuint program);
+	void BindVertexArray(GLuint vao);
+	void ActiveTexture(GLenum unit);
+	// Binds to the active unit; GL_TEXTURE_2D and GL_TEXTURE_2D_ARRAY are tracked per unit
+	void BindTexture(GLenum target, GLuint texture);
+	// GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_STENCIL_TEST and GL_SCISSOR_TEST are tracked, others always go through
+	void Enable(GLenum capability);
+	void Disable(GLenum capability);
+	void ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+
+	void Invalidate();
+	void ResetCounters();
+
+private:
+	enum TrackedCapability
+	{
+		CAPABILITY_DEPTH_TEST,
+		CAPABILITY_CULL_FACE,
+		CAPABILITY_BLEND,
+		CAPABILITY_STENCIL_TEST,
+		CAPABILITY_SCISSOR_TEST,
+		CAPABILITY_COUNT,
+		CAPABILITY_UNTRACKED = CAPABILITY_COUNT
+	};
+
+	// Known flags of each shadowed value
+	bool gProgramKnown;
+	bool gVaoKnown;
+	bool gUnitKnown;
+	bool gTexture2DKnown[MAX_TEXTURE_UNITS];
+	bool gTextureArrayKnown[MAX_TEXTURE_UNITS];
+	bool gCapabilityKnown[CAPABILITY_COUNT];
+	bool gClearColorKnown;
+
+	GLuint gProgram;
+	GLuint gVao;
+	GLuint gUnit;   // Active unit, relative to GL_TEXTURE0
+	GLuint gTexture2D[MAX_TEXTURE_UNITS];
+	GLuint gTextureArray[MAX_TEXTURE_UNITS];
+	bool gCapability[CAPABILITY_COUNT];
+	glm::vec4 gClearColor;
+
+	static TrackedCapability UTrack(GLenum capability);
+	void USetCapability(GLenum capability, bool enabled);
+	// Counts the call and tells whether it must be issued
+	bool UIssue(bool redundant);
+};
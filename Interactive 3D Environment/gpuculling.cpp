@@ -0,0 +1,252 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "gpuculling.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+	// One DrawElementsIndirectCommand: count, instanceCount, firstIndex, baseVertex, baseInstance
+	const GLintptr GPU_CULL_COMMAND_SIZE = 5 * sizeof(GLuint);
+}
+
+
+void GpuCulling::CreateGpuCulling(UniformTable* cullProgram, UniformTable* pyramidProgram)
+{
+	gCullProgram = cullProgram;
+	gPyramidProgram = pyramidProgram;
+	gSourceLevel = pyramidProgram->Find("sourceLevel");
+	// Both programs sample the unit the pyramid pass binds its source and result to
+	cullProgram->Set(cullProgram->Find("depthPyramid"), (GLint)GPU_CULL_PYRAMID_UNIT);
+	pyramidProgram->Set(pyramidProgram->Find("source"), (GLint)GPU_CULL_PYRAMID_UNIT);
+
+	gIndirectCount = GLEW_ARB_indirect_parameters != 0;
+
+	glGenBuffers(1, &gObjectBuffer);
+	glGenBuffers(1, &gMeshBuffer);
+	glGenBuffers(1, &gGroupBuffer);
+	glGenBuffers(1, &gCommandBuffer);
+	glGenBuffers(1, &gCountBuffer);
+	glGenBuffers(1, &gCullBlockBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, gCullBlockBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(CullBlock), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	gGroups.clear();
+	gObjectCount = 0;
+	gDepthTexture = 0;
+	gPyramid = 0;
+	gDepthWidth = 0;
+	gDepthHeight = 0;
+	gPyramidWidth = 0;
+	gPyramidHeight = 0;
+	gPyramidLevels = 0;
+	gDepthViewProjection = glm::mat4(1.0f);
+	gHasPyramid = false;
+
+	std::cout << "INFO: GPU culling draws through " << (gIndirectCount ? "glMultiDrawElementsIndirectCountARB" : "glMultiDrawElementsIndirect over zeroed commands") << std::endl;
+}
+
+
+void GpuCulling::DestroyGpuCulling()
+{
+	glDeleteBuffers(1, &gObjectBuffer);
+	glDeleteBuffers(1, &gMeshBuffer);
+	glDeleteBuffers(1, &gGroupBuffer);
+	glDeleteBuffers(1, &gCommandBuffer);
+	glDeleteBuffers(1, &gCountBuffer);
+	glDeleteBuffers(1, &gCullBlockBuffer);
+	UDestroyPyramid();
+}
+
+
+void GpuCulling::SetScene(const std::vector<GpuCullObject>& objects, const std::vector<GpuCullMesh>& meshes, const std::vector<DrawGroup>& groups)
+{
+	gObjectCount = (GLuint)objects.size();
+	gGroups = groups;
+
+	std::vector<GLuint> firstCommands;
+	for (const DrawGroup& group : groups)
+		firstCommands.push_back(group.firstCommand);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, gObjectBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GpuCullObject) * objects.size(), objects.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, gMeshBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GpuCullMesh) * meshes.size(), meshes.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, gGroupBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * firstCommands.size(), firstCommands.data(), GL_STATIC_DRAW);
+
+	// Written on the GPU and read by the draws, never touched by the CPU
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, gCommandBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, GPU_CULL_COMMAND_SIZE * objects.size(), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, gCountBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * groups.size(), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+
+void GpuCulling::Cull(GLState& state, const Frustum& frustum, const glm::vec3& cameraPosition, bool perspective, GLfloat unitsPerPixel, GLfloat pixelError)
+{
+	CullBlock block;
+	for (GLuint p = 0; p < 6; ++p)
+		block.frustumPlanes[p] = frustum.planes[p];
+	block.depthViewProjection = gDepthViewProjection;
+	block.cameraPosition = glm::vec4(cameraPosition, 1.0f);
+	block.unitsPerPixel = unitsPerPixel;
+	block.pixelError = pixelError;
+	block.perspective = perspective;
+	block.useDepthPyramid = gHasPyramid;
+	block.nObjects = gObjectCount;
+	block.depthWidth = gDepthWidth;
+	block.depthHeight = gDepthHeight;
+	block.pyramidLevels = gPyramidLevels;
+	glBindBuffer(GL_UNIFORM_BUFFER, gCullBlockBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CullBlock), &block);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, GPU_CULL_BLOCK_BINDING, gCullBlockBuffer);
+
+	// Counters restart at zero; without count reads the commands past them must draw nothing
+	const GLuint zero = 0;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, gCountBuffer);
+	glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+	if (!gIndirectCount)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, gCommandBuffer);
+		glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GPU_CULL_OBJECT_BINDING, gObjectBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GPU_CULL_MESH_BINDING, gMeshBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GPU_CULL_GROUP_BINDING, gGroupBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GPU_CULL_COMMAND_BINDING, gCommandBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GPU_CULL_COUNT_BINDING, gCountBuffer);
+	if (gHasPyramid)
+	{
+		state.ActiveTexture(GL_TEXTURE0 + GPU_CULL_PYRAMID_UNIT);
+		state.BindTexture(GL_TEXTURE_2D, gPyramid);
+	}
+
+	state.UseProgram(gCullProgram->gProgram);
+	glDispatchCompute((gObjectCount + GPU_CULL_GROUP_SIZE - 1) / GPU_CULL_GROUP_SIZE, 1, 1);
+	// Commands and counters are read next as indirect and parameter buffers, or copied back for checks
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+
+void GpuCulling::Draw(GLuint group) const
+{
+	const DrawGroup& drawGroup = gGroups[group];
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, gCommandBuffer);
+	if (gIndirectCount)
+	{
+		glBindBuffer(GL_PARAMETER_BUFFER_ARB, gCountBuffer);
+		glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(GPU_CULL_COMMAND_SIZE * drawGroup.firstCommand),
+			(GLintptr)(sizeof(GLuint) * group), drawGroup.nObjects, 0);
+		glBindBuffer(GL_PARAMETER_BUFFER_ARB, 0);
+	}
+	else
+	{
+		// Commands past the counter were cleared to zero indices and instances
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(GPU_CULL_COMMAND_SIZE * drawGroup.firstCommand), drawGroup.nObjects, 0);
+	}
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+
+void GpuCulling::BuildDepthPyramid(GLState& state, GLuint width, GLuint height, const glm::mat4& viewProjection)
+{
+	// Minimized windows have nothing to copy
+	if (width == 0 || height == 0)
+		return;
+	if (width != gDepthWidth || height != gDepthHeight)
+		UCreatePyramid(state, width, height);
+
+	state.ActiveTexture(GL_TEXTURE0 + GPU_CULL_PYRAMID_UNIT);
+	state.BindTexture(GL_TEXTURE_2D, gDepthTexture);
+	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+
+	// Level 0 reduces the depth copy, every other level the one before it
+	state.UseProgram(gPyramidProgram->gProgram);
+	for (GLuint level = 0; level < gPyramidLevels; ++level)
+	{
+		if (level == 1)
+			state.BindTexture(GL_TEXTURE_2D, gPyramid);
+		gPyramidProgram->Set(gSourceLevel, (GLint)(level == 0 ? 0 : level - 1));
+		glBindImageTexture(0, gPyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+		GLuint levelWidth = std::max(gPyramidWidth >> level, 1u);
+		GLuint levelHeight = std::max(gPyramidHeight >> level, 1u);
+		glDispatchCompute((levelWidth + GPU_PYRAMID_GROUP_SIZE - 1) / GPU_PYRAMID_GROUP_SIZE, (levelHeight + GPU_PYRAMID_GROUP_SIZE - 1) / GPU_PYRAMID_GROUP_SIZE, 1);
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+	}
+
+	gDepthViewProjection = viewProjection;
+	gHasPyramid = true;
+}
+
+
+GLuint GpuCulling::ReadVisibleCount() const
+{
+	if (gGroups.empty())
+		return 0;
+
+	std::vector<GLuint> counts(gGroups.size());
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, gCountBuffer);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint) * counts.size(), counts.data());
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	GLuint nVisible = 0;
+	for (GLuint count : counts)
+		nVisible += count;
+	return nVisible;
+}
+
+
+void GpuCulling::UCreatePyramid(GLState& state, GLuint width, GLuint height)
+{
+	// Unbound first, so the state cache never holds a deleted name that glGenTextures may hand out again
+	state.ActiveTexture(GL_TEXTURE0 + GPU_CULL_PYRAMID_UNIT);
+	state.BindTexture(GL_TEXTURE_2D, 0);
+	UDestroyPyramid();
+
+	gDepthWidth = width;
+	gDepthHeight = height;
+	// Level sizes halve rounding down, the reduction folds the odd last row and column into the texel before them
+	gPyramidWidth = std::max(width / 2, 1u);
+	gPyramidHeight = std::max(height / 2, 1u);
+	gPyramidLevels = 1;
+	while ((std::max(gPyramidWidth, gPyramidHeight) >> gPyramidLevels) > 0)
+		++gPyramidLevels;
+
+	glGenTextures(1, &gDepthTexture);
+	state.BindTexture(GL_TEXTURE_2D, gDepthTexture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glGenTextures(1, &gPyramid);
+	state.BindTexture(GL_TEXTURE_2D, gPyramid);
+	glTexStorage2D(GL_TEXTURE_2D, gPyramidLevels, GL_R32F, gPyramidWidth, gPyramidHeight);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+
+void GpuCulling::UDestroyPyramid()
+{
+	if (gDepthTexture != 0)
+		glDeleteTextures(1, &gDepthTexture);
+	if (gPyramid != 0)
+		glDeleteTextures(1, &gPyramid);
+	gDepthTexture = 0;
+	gPyramid = 0;
+	gDepthWidth = 0;
+	gDepthHeight = 0;
+	gHasPyramid = false;
+}
@@ -0,0 +1,165 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+#include "frustum.h"
+#include "glstate.h"
+#include "meshes.h"
+#include "uniforms.h"
+
+/* Bindings of the culling pass, matching the layout qualifiers of the compute shaders.
+ * Shader storage bindings 0 and 1 hold the draw records and material handles, uniform block 0 the FrameBlock.
+ */
+const GLuint GPU_CULL_BLOCK_BINDING = 1;
+const GLuint GPU_CULL_OBJECT_BINDING = 2;
+const GLuint GPU_CULL_MESH_BINDING = 3;
+const GLuint GPU_CULL_GROUP_BINDING = 4;
+const GLuint GPU_CULL_COMMAND_BINDING = 5;
+const GLuint GPU_CULL_COUNT_BINDING = 6;
+// Texture unit the culling pass reads the depth pyramid from; unit 0 holds the material textures
+const GLuint GPU_CULL_PYRAMID_UNIT = 1;
+// Work group sizes, local_size_x of the culling shader and local_size_x and y of the pyramid shader
+const GLuint GPU_CULL_GROUP_SIZE = 64;
+const GLuint GPU_PYRAMID_GROUP_SIZE = 8;
+
+// Bounds of one object, laid out like the std430 CullObject array in the culling shader
+struct GpuCullObject
+{
+	glm::vec4 sphere;       // Center, radius in w
+	glm::vec4 boxCenter;    // w unused
+	glm::vec4 boxExtent;    // Half size, largest axis scale of the model in w
+	GLuint mesh;            // Index into the mesh table
+	GLuint group;           // Draw group the object's command goes to
+	GLuint padding[2];
+};
+
+static_assert(sizeof(GpuCullObject) == 64, "GpuCullObject does not match the std430 layout");
+
+// Detail level of a mesh table entry, firstIndex counts from the start of the shared index buffer
+struct GpuCullLod
+{
+	GLuint firstIndex;
+	GLuint nIndices;
+	GLfloat error;
+	GLuint padding;
+};
+
+// Detail chain of one mesh, laid out like the std430 CullMesh array in the culling shader
+struct GpuCullMesh
+{
+	GLint baseVertex;
+	GLuint nLods;
+	GLuint padding[2];
+	GpuCullLod lods[Meshes::MESH_MAX_LODS];
+};
+
+static_assert(sizeof(GpuCullMesh) == 112, "GpuCullMesh does not match the std430 layout");
+
+/* View data of one culling pass, laid out like the std140 CullBlock in the culling shader.
+ * Detail levels are picked with the same arithmetic as RenderQueue::BuildPackets, so both paths agree.
+ */
+struct CullBlock
+{
+	glm::vec4 frustumPlanes[6];
+	glm::mat4 depthViewProjection;  // View projection the depth pyramid was rendered with
+	glm::vec4 cameraPosition;       // w unused
+	GLfloat unitsPerPixel;
+	GLfloat pixelError;
+	GLuint perspective;
+	GLuint useDepthPyramid;         // 0 until a pyramid has been built
+	GLuint nObjects;
+	GLuint depthWidth;              // Size of the depth buffer the pyramid was built from
+	GLuint depthHeight;
+	GLuint pyramidLevels;
+};
+
+static_assert(offsetof(CullBlock, depthViewProjection) == 96, "CullBlock does not match the std140 layout");
+static_assert(offsetof(CullBlock, cameraPosition) == 160, "CullBlock does not match the std140 layout");
+static_assert(offsetof(CullBlock, unitsPerPixel) == 176, "CullBlock does not match the std140 layout");
+static_assert(sizeof(CullBlock) == 208, "CullBlock does not match the std140 layout");
+
+/* Frustum and depth pyramid culling in a compute pass, for scenes too large to cull on the CPU.
+ * SetScene uploads the objects once. Cull tests every object and writes one indirect command per visible
+ * object, packed at the front of its group's range of the command buffer, with the number written into the
+ * group's counter. BuildDepthPyramid reduces the frame's depth buffer to max depth mip levels; the next Cull
+ * tests boxes against them with the view projection they were rendered with, so an object coming out from
+ * behind an occluder appears one frame late.
+ */
+class GpuCulling
+{
+public:
+	// Objects drawn with one program and VAO get one command range and one multi-draw
+	struct DrawGroup
+	{
+		GLuint firstCommand;
+		GLuint nObjects;
+		GLuint material;    // Material of the group's first object, the program to bind is that of the material
+		GLuint vao;
+	};
+
+	std::vector<DrawGroup> gGroups;
+	GLuint gObjectCount;
+	// glMultiDrawElementsIndirectCountARB reads the group counters; without it the tail of each range is zeroed
+	bool gIndirectCount;
+
+	// Indirect commands and per group counters written by Cull, readable for checks
+	GLuint gCommandBuffer;
+	GLuint gCountBuffer;
+	// Max depth of 2 x 2 texels per level, level 0 at half the depth buffer size
+	GLuint gPyramid;
+	GLuint gPyramidWidth;
+	GLuint gPyramidHeight;
+	GLuint gPyramidLevels;
+
+public:
+	/* cullProgram runs the culling shader and pyramidProgram the reduction shader; both compute programs.
+	 * The depth pyramid is created by the first BuildDepthPyramid.
+	 */
+	void CreateGpuCulling(UniformTable* cullProgram, UniformTable* pyramidProgram);
+	void DestroyGpuCulling();
+
+	// Uploads the objects, the detail chains of their meshes and their groups, objects counted in group order
+	void SetScene(const std::vector<GpuCullObject>& objects, const std::vector<GpuCullMesh>& meshes, const std::vector<DrawGroup>& groups);
+
+	// Fills the command buffer for the view; the culled object's index goes to baseInstance
+	void Cull(GLState& state, const Frustum& frustum, const glm::vec3& cameraPosition, bool perspective, GLfloat unitsPerPixel, GLfloat pixelError);
+
+	// Issues the commands of one group, the caller binds its program, VAO and draw records
+	void Draw(GLuint group) const;
+
+	// Copies the depth of the bound framebuffer, width by height, and rebuilds the pyramid from it
+	void BuildDepthPyramid(GLState& state, GLuint width, GLuint height, const glm::mat4& viewProjection);
+
+	// Objects the last Cull let through; waits for the GPU
+	GLuint ReadVisibleCount() const;
+
+private:
+	UniformTable* gCullProgram;
+	UniformTable* gPyramidProgram;
+	GLint gSourceLevel;     // Handle of the pyramid shader's sourceLevel
+
+	GLuint gObjectBuffer;
+	GLuint gMeshBuffer;
+	GLuint gGroupBuffer;
+	GLuint gCullBlockBuffer;
+
+	GLuint gDepthTexture;   // Copy of the depth buffer the pyramid is reduced from
+	GLuint gDepthWidth;
+	GLuint gDepthHeight;
+	glm::mat4 gDepthViewProjection;
+	bool gHasPyramid;
+
+	void UCreatePyramid(GLState& state, GLuint width, GLuint height);
+	void UDestroyPyramid();
+};
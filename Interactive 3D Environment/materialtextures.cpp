@@ -0,0 +1,124 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "materialtextures.h"
+
+#include <cmath>
+#include <iostream>
+
+bool MaterialTextures::CreateMaterialTextures(const GLuint* textures, GLuint nTextures, bool bindless)
+{
+	gBindless = bindless;
+	gArrayId = 0;
+	gHandleBuffer = 0;
+	gHandles.clear();
+
+	bool created = bindless ? UCreateHandles(textures, nTextures) : UCreateArray(textures, nTextures);
+	if (created)
+		std::cout << "INFO: " << nTextures << " material textures " << (bindless ? "bound through bindless handles" : "packed into a texture array") << std::endl;
+	return created;
+}
+
+
+void MaterialTextures::DestroyMaterialTextures()
+{
+	for (GLuint64 handle : gHandles)
+		glMakeTextureHandleNonResidentARB(handle);
+	gHandles.clear();
+
+	glDeleteBuffers(1, &gHandleBuffer);
+	glDeleteTextures(1, &gArrayId);
+	gHandleBuffer = 0;
+	gArrayId = 0;
+}
+
+
+void MaterialTextures::BindMaterialTextures(GLState& state) const
+{
+	if (gBindless)
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIAL_HANDLE_BINDING, gHandleBuffer);
+	}
+	else
+	{
+		state.ActiveTexture(GL_TEXTURE0);
+		state.BindTexture(GL_TEXTURE_2D_ARRAY, gArrayId);
+	}
+}
+
+
+bool MaterialTextures::UCreateArray(const GLuint* textures, GLuint nTextures)
+{
+	GLsizei levels = 1 + (GLsizei)std::floor(std::log2((float)MATERIAL_TEXTURE_SIZE));
+
+	glGenTextures(1, &gArrayId);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, gArrayId);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, MATERIAL_TEXTURE_SIZE, MATERIAL_TEXTURE_SIZE, nTextures);
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters, resampled layers need the mipmaps
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// The GPU scales each source texture into its layer
+	GLuint framebuffers[2];
+	glGenFramebuffers(2, framebuffers);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]);
+
+	bool complete = true;
+	for (GLuint layer = 0; layer < nTextures && complete; ++layer)
+	{
+		GLint width = 0;
+		GLint height = 0;
+		glBindTexture(GL_TEXTURE_2D, textures[layer]);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[layer], 0);
+		glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, gArrayId, 0, layer);
+
+		complete = glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE
+			&& glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+		if (complete)
+			glBlitFramebuffer(0, 0, width, height, 0, 0, MATERIAL_TEXTURE_SIZE, MATERIAL_TEXTURE_SIZE, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		else
+			std::cout << "ERROR: Could not copy material texture " << layer << " into the texture array" << std::endl;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(2, framebuffers);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (complete)
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	return complete;
+}
+
+
+bool MaterialTextures::UCreateHandles(const GLuint* textures, GLuint nTextures)
+{
+	for (GLuint i = 0; i < nTextures; ++i)
+	{
+		GLuint64 handle = glGetTextureHandleARB(textures[i]);
+		if (handle == 0)
+		{
+			std::cout << "ERROR: Could not get a bindless handle for material texture " << i << std::endl;
+			return false;
+		}
+		glMakeTextureHandleResidentARB(handle);
+		gHandles.push_back(handle);
+	}
+
+	glGenBuffers(1, &gHandleBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, gHandleBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint64) * gHandles.size(), gHandles.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	return true;
+}
@@ -0,0 +1,43 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <vector>
+
+#include "glstate.h"
+
+// Width and height of every texture array layer, source textures are resampled to it
+const GLsizei MATERIAL_TEXTURE_SIZE = 1024;
+// Shader storage binding of the bindless handles, matches binding = 1 in the fragment shader
+const GLuint MATERIAL_HANDLE_BINDING = 1;
+
+/* Textures of every material behind one binding, so draws select their texture by material index.
+ * With ARB_bindless_texture each source texture gets a resident handle, stored in a shader storage buffer.
+ * Otherwise the textures are resampled into the layers of one GL_TEXTURE_2D_ARRAY.
+ */
+class MaterialTextures
+{
+public:
+	bool gBindless;
+	GLuint gArrayId;                // Texture array, layer i holds material i (array path)
+	GLuint gHandleBuffer;           // Handle of material i at index i (bindless path)
+	std::vector<GLuint64> gHandles;
+
+public:
+	// Source textures must stay alive while bindless handles refer to them
+	bool CreateMaterialTextures(const GLuint* textures, GLuint nTextures, bool bindless);
+	void DestroyMaterialTextures();
+
+	// Binds the texture array to unit 0 or the handle buffer, once per frame
+	void BindMaterialTextures(GLState& state) const;
+
+private:
+	bool UCreateArray(const GLuint* textures, GLuint nTextures);
+	bool UCreateHandles(const GLuint* textures, GLuint nTextures);
+};
@@ -0,0 +1,200 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "meshcache.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// Rounds a file offset up to the next 16 byte boundary
+	GLuint UAlign16(GLuint offset)
+	{
+		return (offset + 15u) & ~15u;
+	}
+
+	// Pads the file with zeros up to the given offset
+	bool UPadTo(FILE* file, GLuint& position, GLuint offset)
+	{
+		static const unsigned char zeros[16] = {};
+		size_t padding = offset - position;
+		position = offset;
+		return padding == 0 || fwrite(zeros, 1, padding, file) == padding;
+	}
+}
+
+
+bool UMapFile(const char* filename, MappedFile& file)
+{
+	file.data = nullptr;
+	file.size = 0;
+	file.fileHandle = nullptr;
+	file.mappingHandle = nullptr;
+
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(handle);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		CloseHandle(handle);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL)
+	{
+		CloseHandle(mapping);
+		CloseHandle(handle);
+		return false;
+	}
+
+	file.data = (const unsigned char*)view;
+	file.size = (size_t)size.QuadPart;
+	file.fileHandle = handle;
+	file.mappingHandle = mapping;
+#else
+	int descriptor = open(filename, O_RDONLY);
+	if (descriptor < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(descriptor, &info) != 0 || info.st_size == 0)
+	{
+		close(descriptor);
+		return false;
+	}
+
+	void* view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	// The mapping stays valid after the descriptor is closed
+	close(descriptor);
+	if (view == MAP_FAILED)
+		return false;
+
+	file.data = (const unsigned char*)view;
+	file.size = (size_t)info.st_size;
+#endif
+
+	return true;
+}
+
+
+void UUnmapFile(MappedFile& file)
+{
+	if (file.data == nullptr)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(file.data);
+	CloseHandle((HANDLE)file.mappingHandle);
+	CloseHandle((HANDLE)file.fileHandle);
+#else
+	munmap((void*)file.data, file.size);
+#endif
+
+	file.data = nullptr;
+	file.size = 0;
+}
+
+
+GLuint UHashMeshCacheInputs(const void* data, size_t bytes, GLuint hash)
+{
+	const unsigned char* bytePointer = (const unsigned char*)data;
+	for (size_t i = 0; i < bytes; ++i)
+		hash = (hash ^ bytePointer[i]) * 16777619u;
+	return hash;
+}
+
+
+const MeshCacheHeader* UValidateMeshCache(const MappedFile& file, GLuint vertexFormat, GLuint meshCount, GLuint meshRecordSize, GLuint pipelineHash)
+{
+	if (file.size < sizeof(MeshCacheHeader))
+		return nullptr;
+
+	const MeshCacheHeader* header = (const MeshCacheHeader*)file.data;
+	if (header->magic != MESH_CACHE_MAGIC || header->version != MESH_CACHE_VERSION)
+		return nullptr;
+	if (header->vertexFormat != vertexFormat || header->meshCount != meshCount || header->meshRecordSize != meshRecordSize)
+		return nullptr;
+	// Built with other detail levels, welding steps, cache size or meshlet limits
+	if (header->pipelineHash != pipelineHash)
+		return nullptr;
+
+	// Every block has to lie inside the file
+	if ((size_t)header->blocks[MESH_CACHE_MESHES].bytes != (size_t)meshCount * meshRecordSize)
+		return nullptr;
+	for (GLuint b = 0; b < MESH_CACHE_BLOCK_COUNT; ++b)
+	{
+		if ((size_t)header->blocks[b].offset + header->blocks[b].bytes > file.size)
+			return nullptr;
+	}
+
+	return header;
+}
+
+
+bool UWriteMeshCache(const char* filename, GLuint vertexFormat, GLuint meshCount, GLuint meshRecordSize, GLuint pipelineHash,
+	const MeshCacheData blocks[MESH_CACHE_BLOCK_COUNT])
+{
+	MeshCacheHeader header;
+	std::memset(&header, 0, sizeof(header));
+	header.magic = MESH_CACHE_MAGIC;
+	header.version = MESH_CACHE_VERSION;
+	header.vertexFormat = vertexFormat;
+	header.meshCount = meshCount;
+	header.meshRecordSize = meshRecordSize;
+	header.pipelineHash = pipelineHash;
+
+	GLuint offset = sizeof(MeshCacheHeader);
+	for (GLuint b = 0; b < MESH_CACHE_BLOCK_COUNT; ++b)
+	{
+		header.blocks[b].offset = UAlign16(offset);
+		header.blocks[b].bytes = blocks[b].bytes;
+		offset = header.blocks[b].offset + blocks[b].bytes;
+	}
+
+	FILE* file = fopen(filename, "wb");
+	if (file == NULL)
+		return false;
+
+	GLuint position = sizeof(header);
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+	for (GLuint b = 0; b < MESH_CACHE_BLOCK_COUNT && written; ++b)
+	{
+		written = UPadTo(file, position, header.blocks[b].offset)
+			&& (blocks[b].bytes == 0 || fwrite(blocks[b].data, 1, blocks[b].bytes, file) == blocks[b].bytes);
+		position += blocks[b].bytes;
+	}
+
+	fclose(file);
+
+	// Never leave a truncated cache behind
+	if (!written)
+		remove(filename);
+
+	return written;
+}
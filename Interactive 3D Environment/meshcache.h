@@ -0,0 +1,79 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+// Identifies a mesh cache file ("MESH" in little endian)
+const GLuint MESH_CACHE_MAGIC = 0x4853454D;
+// Bump whenever the file layout or the code of the generation and optimization passes changes.
+// Changes to the constants the passes use are caught by the pipeline hash instead.
+const GLuint MESH_CACHE_VERSION = 6;
+
+// Blocks stored in a mesh cache file, in file order
+enum MeshCacheBlock
+{
+	MESH_CACHE_MESHES,              // Mesh records
+	MESH_CACHE_VERTICES,            // Vertex data, already in the GPU vertex format
+	MESH_CACHE_INDICES,             // Index data
+	MESH_CACHE_MESHLETS,            // Meshlet records
+	MESH_CACHE_MESHLET_VERTICES,    // Meshlet vertex table
+	MESH_CACHE_MESHLET_TRIANGLES,   // Meshlet triangle table
+	MESH_CACHE_BLOCK_COUNT
+};
+
+// Where a block lives, offsets are from the start of the file and 16 byte aligned
+struct MeshCacheRange
+{
+	GLuint offset;
+	GLuint bytes;
+};
+
+// Layout of a mesh cache file: this header followed by its blocks
+struct MeshCacheHeader
+{
+	GLuint magic;
+	GLuint version;
+	GLuint vertexFormat;    // VertexFormat the vertex data is stored in
+	GLuint meshCount;
+	GLuint meshRecordSize;  // sizeof the in-memory mesh record, catches layout changes
+	GLuint pipelineHash;    // UHashMeshCacheInputs of everything the geometry was built from
+	MeshCacheRange blocks[MESH_CACHE_BLOCK_COUNT];
+};
+
+// Contents of a block to write
+struct MeshCacheData
+{
+	const void* data;
+	GLuint bytes;
+};
+
+// Read-only view of a whole file mapped into the address space
+struct MappedFile
+{
+	const unsigned char* data;
+	size_t size;
+	void* fileHandle;       // Platform handles, only meaningful while mapped
+	void* mappingHandle;
+};
+
+bool UMapFile(const char* filename, MappedFile& file);
+void UUnmapFile(MappedFile& file);
+
+// FNV-1a over bytes, chained through hash so several inputs combine into one pipeline hash
+GLuint UHashMeshCacheInputs(const void* data, size_t bytes, GLuint hash = 2166136261u);
+
+/* Returns the header of a mapped cache if it is complete and matches what the caller expects,
+ * nullptr otherwise.
+ */
+const MeshCacheHeader* UValidateMeshCache(const MappedFile& file, GLuint vertexFormat, GLuint meshCount, GLuint meshRecordSize, GLuint pipelineHash);
+
+// Writes a cache file from its blocks, returns false if the file could not be written
+bool UWriteMeshCache(const char* filename, GLuint vertexFormat, GLuint meshCount, GLuint meshRecordSize, GLuint pipelineHash,
+	const MeshCacheData blocks[MESH_CACHE_BLOCK_COUNT]);
@@ -10,18 +10,57 @@ Version: 1.0
 
 #include <glm/glm.hpp>
 
+#include <vector>
+
+#include "primitives.h"
+#include "bounds.h"
+#include "meshlets.h"
+#include "vertexformat.h"
+
 class Meshes
 {
-	// Stores the GL data relative to a given mesh
+public:
+	static const GLuint MESH_COUNT = 6;
+	// Authored or generated levels plus the ones added by simplification
+	static const GLuint MESH_MAX_LODS = 6;
+
+	// Index range of one detail level inside the mesh's buffers
+	struct GLMeshLod
+	{
+		GLuint firstIndex;  // Offset of the first index of the level, relative to the mesh's first index
+		GLuint nIndices;    // Number of indices of the level
+		GLfloat error;      // Distance the level may deviate from the exact surface, in mesh units
+	};
+
+	// Stores the range a given mesh occupies in the shared geometry buffers
 	struct GLMesh
 	{
-		GLuint vao;         // Handle for the vertex array object
-		GLuint vbos[2];     // Handles for the vertex buffer objects
+		GLuint baseVertex;  // First vertex of the mesh in the shared vertex buffer
+		GLuint firstIndex;  // First index of the mesh in the shared index buffer
 		GLuint nVertices;   // Number of vertices for the mesh
-		GLuint nIndices;    // Number of indices for the mesh
+		GLuint nIndices;    // Number of indices of the most detailed level
+		GLuint nLods;       // Number of detail levels, at least 1
+		GLMeshLod lods[MESH_MAX_LODS]; // Detail levels, most detailed first
+		glm::vec3 positionOffset; // Dequantization of packed positions (0 for float vertices)
+		glm::vec3 positionScale;  // Dequantization of packed positions (1 for float vertices)
+		GLuint firstMeshlet;      // First meshlet of the most detailed level in gMeshlets
+		GLuint nMeshlets;         // Number of meshlets of the most detailed level
+		BoundingBox box;          // Bounds of every vertex, in mesh units
+		BoundingSphere sphere;
 	};
 
-public:
+	// Shared geometry buffers holding every mesh
+	GLuint gVao;         // Handle for the vertex array object
+	GLuint gVbos[2];     // Handles for the vertex and index buffer objects
+	VertexFormat gVertexFormat; // Layout of the shared vertex buffer
+	MeshletTables gMeshlets;    // Cluster culling data of every mesh
+	bool gFromCache;            // Whether CreateMeshes loaded the cache file instead of building
+	// CPU copies of the vertices (decoded, positions in mesh units) and indices, indexed like the shared buffers
+	std::vector<glm::vec3> gPositions;
+	std::vector<glm::vec3> gNormals;
+	std::vector<glm::vec2> gTexCoords;
+	std::vector<GLuint> gIndices;
+
 	GLMesh gCylinderMesh;
 	GLMesh gPlaneMesh;
 	GLMesh gConeMesh;
@@ -30,9 +69,16 @@ public:
 	GLMesh gHexagonMesh;
 
 public:
-	void CreateMeshes();
+	// Without useCache every mesh is rebuilt and the cache file rewritten, as on a first run
+	void CreateMeshes(VertexFormat format = VERTEX_FORMAT_FLOAT, bool useCache = true);
 	void DestroyMeshes();
 
+	// Another VAO over the shared buffers with the vertex attributes of gVao, for passes that add attributes of their own
+	GLuint CreateVertexArray() const;
+
+	// Coarsest detail level whose error covers at most maxError once the mesh is scaled by worldScale
+	const GLMeshLod& SelectLod(const GLMesh& mesh, GLfloat worldScale, GLfloat maxError) const;
+
 private:
 	void UCreateCylinderMesh(GLMesh& mesh);
 	void UCreateConeMesh(GLMesh& mesh);
@@ -41,5 +87,28 @@ private:
 	void UCreateCubeMesh(GLMesh& mesh);
 	void UCreateHexagonMesh(GLMesh& mesh);
 
-	void UDestroyMesh(GLMesh& mesh);
-};
\ No newline at end of file
+	void UAppendMesh(GLMesh& mesh, const GLfloat* verts, GLuint nVertices, const GLuint* indices, GLuint nIndices);
+	void UAppendPrimitive(GLMesh& mesh, const PrimitiveDesc lods[PRIMITIVE_LOD_COUNT]);
+	void UBuildLodChain(GLMesh& mesh);
+	void UWeldMeshes();
+	void UOptimizeMeshes();
+	void UPackMeshes(std::vector<PackedVertex>& packed);
+	void UBuildMeshletTables();
+
+	// Generates, optimizes and caches every mesh, or loads them from the cache file
+	void UBuildMeshes();
+	bool ULoadMeshes();
+	void UCreateArena(const void* vertexData, GLuint vertexBytes, const void* indexData, GLuint indexBytes);
+	// Fills the CPU copies of the vertices and indices from the data handed to the GPU, for work that stays on the CPU
+	void UKeepVertices(const void* vertexData, GLuint vertexBytes, const void* indexData, GLuint indexBytes);
+
+	// Every mesh with a readable name, for the passes that run over all of them
+	void UListMeshes(GLMesh* list[MESH_COUNT], const char* names[MESH_COUNT]);
+
+	// CPU copies of the shared buffers, released once uploaded
+	std::vector<GLfloat> stagingVerts;
+	std::vector<GLuint> stagingIndices;
+};
+
+// Points attributes 0 to 2 of the bound VAO at the vertex buffer bound to GL_ARRAY_BUFFER, laid out in format
+void UBindVertexAttributes(VertexFormat format);
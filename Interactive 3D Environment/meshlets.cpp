@@ -0,0 +1,234 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "meshlets.h"
+#include "primitives.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	glm::vec3 UPosition(const GLfloat* verts, GLuint vertex)
+	{
+		const GLfloat* v = verts + vertex * PRIMITIVE_FLOATS_PER_VERTEX;
+		return glm::vec3(v[0], v[1], v[2]);
+	}
+
+	// Computes the bounding sphere and normal cone of a finished meshlet
+	void UComputeMeshletBounds(Meshlet& meshlet, const MeshletTables& tables, const GLfloat* verts)
+	{
+		const GLuint* vertices = &tables.vertices[meshlet.vertexOffset];
+		const GLubyte* triangles = &tables.triangles[meshlet.triangleOffset];
+
+		// Sphere around the box center, tight enough for clusters of this size
+		glm::vec3 lower = UPosition(verts, vertices[0]);
+		glm::vec3 upper = lower;
+		for (GLuint v = 1; v < meshlet.nVertices; ++v)
+		{
+			glm::vec3 p = UPosition(verts, vertices[v]);
+			lower = glm::min(lower, p);
+			upper = glm::max(upper, p);
+		}
+		meshlet.center = (lower + upper) * 0.5f;
+		meshlet.radius = 0.0f;
+		for (GLuint v = 0; v < meshlet.nVertices; ++v)
+			meshlet.radius = std::max(meshlet.radius, glm::length(UPosition(verts, vertices[v]) - meshlet.center));
+
+		// Cone around the average facing that contains every triangle normal
+		std::vector<glm::vec3> normals;
+		glm::vec3 axis(0.0f);
+		for (GLuint t = 0; t < meshlet.nTriangles; ++t)
+		{
+			glm::vec3 p0 = UPosition(verts, vertices[triangles[t * 3]]);
+			glm::vec3 p1 = UPosition(verts, vertices[triangles[t * 3 + 1]]);
+			glm::vec3 p2 = UPosition(verts, vertices[triangles[t * 3 + 2]]);
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			GLfloat length = glm::length(normal);
+			// Degenerate triangles never cover a pixel, so they do not widen the cone
+			if (length == 0.0f)
+				continue;
+
+			normals.push_back(normal / length);
+			axis += normal / length;
+		}
+
+		GLfloat axisLength = glm::length(axis);
+		meshlet.coneAxis = axisLength > 0.0f ? axis / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+		meshlet.coneCosAngle = axisLength > 0.0f ? 1.0f : -1.0f;
+		for (const glm::vec3& normal : normals)
+			meshlet.coneCosAngle = std::min(meshlet.coneCosAngle, glm::dot(meshlet.coneAxis, normal));
+	}
+}
+
+
+GLuint UBuildMeshlets(const GLuint* indices, GLuint nIndices, const GLfloat* verts, MeshletTables& tables)
+{
+	const GLuint unassigned = ~0u;
+	GLuint nVertices = 0;
+	for (GLuint i = 0; i < nIndices; ++i)
+		nVertices = std::max(nVertices, indices[i] + 1);
+
+	// Meshlet-local number of each mesh vertex in the meshlet being filled
+	std::vector<GLuint> local(nVertices, unassigned);
+	GLuint firstMeshlet = (GLuint)tables.meshlets.size();
+
+	Meshlet meshlet = {};
+	meshlet.vertexOffset = (GLuint)tables.vertices.size();
+	meshlet.triangleOffset = (GLuint)tables.triangles.size();
+
+	for (GLuint t = 0; t + 2 < nIndices; t += 3)
+	{
+		GLuint newVertices = 0;
+		for (GLuint corner = 0; corner < 3; ++corner)
+			newVertices += local[indices[t + corner]] == unassigned;
+
+		// Close the meshlet once the triangle no longer fits
+		if (meshlet.nVertices + newVertices > MESHLET_MAX_VERTICES || meshlet.nTriangles + 1 > MESHLET_MAX_TRIANGLES)
+		{
+			UComputeMeshletBounds(meshlet, tables, verts);
+			tables.meshlets.push_back(meshlet);
+
+			for (GLuint v = 0; v < meshlet.nVertices; ++v)
+				local[tables.vertices[meshlet.vertexOffset + v]] = unassigned;
+			meshlet = Meshlet();
+			meshlet.vertexOffset = (GLuint)tables.vertices.size();
+			meshlet.triangleOffset = (GLuint)tables.triangles.size();
+		}
+
+		for (GLuint corner = 0; corner < 3; ++corner)
+		{
+			GLuint vertex = indices[t + corner];
+			if (local[vertex] == unassigned)
+			{
+				local[vertex] = meshlet.nVertices++;
+				tables.vertices.push_back(vertex);
+			}
+			tables.triangles.push_back((GLubyte)local[vertex]);
+		}
+		++meshlet.nTriangles;
+	}
+
+	if (meshlet.nTriangles > 0)
+	{
+		UComputeMeshletBounds(meshlet, tables, verts);
+		tables.meshlets.push_back(meshlet);
+	}
+
+	return (GLuint)tables.meshlets.size() - firstMeshlet;
+}
+
+
+void UExtractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+{
+	// Gribb / Hartmann: each plane is the last row plus or minus one of the other rows
+	glm::vec4 rows[4];
+	for (GLuint r = 0; r < 4; ++r)
+		rows[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+
+	planes[0] = rows[3] + rows[0]; // left
+	planes[1] = rows[3] - rows[0]; // right
+	planes[2] = rows[3] + rows[1]; // bottom
+	planes[3] = rows[3] - rows[1]; // top
+	planes[4] = rows[3] + rows[2]; // near
+	planes[5] = rows[3] - rows[2]; // far
+
+	for (GLuint p = 0; p < 6; ++p)
+		planes[p] /= glm::length(glm::vec3(planes[p]));
+}
+
+
+bool UMeshletVisible(const Meshlet& meshlet, const glm::mat4& model, const glm::vec3& cameraPosition, const glm::vec4 planes[6])
+{
+	// Both tests run in mesh space, which keeps them exact under non-uniform scale
+	for (GLuint p = 0; p < 6; ++p)
+	{
+		glm::vec4 plane = glm::transpose(model) * planes[p];
+		if (glm::dot(glm::vec3(plane), meshlet.center) + plane.w < -meshlet.radius * glm::length(glm::vec3(plane)))
+			return false;
+	}
+
+	// Cones wider than a hemisphere always contain a normal facing the camera
+	if (meshlet.coneCosAngle <= 0.0f)
+		return true;
+
+	// The camera sees no triangle if, from every point of the sphere, it lies behind every normal in the cone
+	glm::vec3 camera = glm::vec3(glm::inverse(model) * glm::vec4(cameraPosition, 1.0f));
+	glm::vec3 toMeshlet = meshlet.center - camera;
+	GLfloat distance = glm::length(toMeshlet);
+	if (distance <= meshlet.radius)
+		return true;
+
+	GLfloat cosView = glm::dot(toMeshlet, meshlet.coneAxis) / distance;
+	GLfloat sinView = std::sqrt(std::max(0.0f, 1.0f - cosView * cosView));
+	GLfloat sinCone = std::sqrt(std::max(0.0f, 1.0f - meshlet.coneCosAngle * meshlet.coneCosAngle));
+	// Cosine of the widest angle between the view direction and a normal in the cone
+	GLfloat cosWidest = cosView * meshlet.coneCosAngle - sinView * sinCone;
+	return distance * cosWidest < meshlet.radius;
+}
+
+
+GLuint UValidateMeshletCulling(const MeshletTables& tables, GLuint firstMeshlet, GLuint nMeshlets, const GLfloat* verts)
+{
+	// Bounds of every meshlet together, the cameras circle around them
+	glm::vec3 center(0.0f);
+	GLfloat radius = 0.0f;
+	for (GLuint m = firstMeshlet; m < firstMeshlet + nMeshlets; ++m)
+		center += tables.meshlets[m].center / (GLfloat)nMeshlets;
+	for (GLuint m = firstMeshlet; m < firstMeshlet + nMeshlets; ++m)
+		radius = std::max(radius, glm::length(tables.meshlets[m].center - center) + tables.meshlets[m].radius);
+
+	const GLuint nCameras = 64;
+	const GLfloat goldenAngle = 2.39996323f;
+	GLuint failures = 0;
+
+	for (GLuint c = 0; c < nCameras; ++c)
+	{
+		// Fibonacci sphere of directions at a few distances, looking at the mesh
+		GLfloat y = 1.0f - 2.0f * (c + 0.5f) / nCameras;
+		GLfloat ring = std::sqrt(1.0f - y * y);
+		glm::vec3 direction(ring * std::cos(goldenAngle * c), y, ring * std::sin(goldenAngle * c));
+		glm::vec3 camera = center + direction * radius * (1.5f + (c % 4));
+		glm::vec3 up = std::abs(y) > 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		// A narrow view off to the side so the frustum planes cut through the mesh
+		glm::vec3 target = center + glm::cross(direction, up) * radius * 0.5f;
+		glm::mat4 viewProjection = glm::perspective(glm::radians(30.0f), 1.0f, 0.1f, 100.0f) * glm::lookAt(camera, target, up);
+
+		glm::vec4 planes[6];
+		UExtractFrustumPlanes(viewProjection, planes);
+
+		for (GLuint m = firstMeshlet; m < firstMeshlet + nMeshlets; ++m)
+		{
+			const Meshlet& meshlet = tables.meshlets[m];
+			if (UMeshletVisible(meshlet, glm::mat4(1.0f), camera, planes))
+				continue;
+
+			// A rejected triangle must either face away or lie fully outside one plane
+			for (GLuint t = 0; t < meshlet.nTriangles; ++t)
+			{
+				glm::vec3 p[3];
+				for (GLuint corner = 0; corner < 3; ++corner)
+					p[corner] = UPosition(verts, tables.vertices[meshlet.vertexOffset + tables.triangles[meshlet.triangleOffset + t * 3 + corner]]);
+
+				bool backFacing = glm::dot(glm::cross(p[1] - p[0], p[2] - p[0]), camera - p[0]) <= 0.0f;
+				bool outside = false;
+				for (GLuint plane = 0; plane < 6 && !outside; ++plane)
+				{
+					outside = glm::dot(glm::vec3(planes[plane]), p[0]) + planes[plane].w < 0.0f
+						&& glm::dot(glm::vec3(planes[plane]), p[1]) + planes[plane].w < 0.0f
+						&& glm::dot(glm::vec3(planes[plane]), p[2]) + planes[plane].w < 0.0f;
+				}
+
+				if (!backFacing && !outside)
+					++failures;
+			}
+		}
+	}
+
+	return failures;
+}
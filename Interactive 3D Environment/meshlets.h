@@ -0,0 +1,58 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Limits of one meshlet, sized for mesh shader friendly clusters
+const GLuint MESHLET_MAX_VERTICES = 64;
+const GLuint MESHLET_MAX_TRIANGLES = 124;
+
+// Small cluster of triangles with the bounds used to cull it as a whole
+struct Meshlet
+{
+	GLuint vertexOffset;    // First entry of the meshlet in the meshlet vertex table
+	GLuint triangleOffset;  // First byte of the meshlet in the meshlet triangle table
+	GLuint nVertices;       // Number of unique vertices, at most MESHLET_MAX_VERTICES
+	GLuint nTriangles;      // Number of triangles, at most MESHLET_MAX_TRIANGLES
+	glm::vec3 center;       // Bounding sphere of the triangles, in mesh units
+	GLfloat radius;
+	glm::vec3 coneAxis;     // Average facing of the triangles
+	GLfloat coneCosAngle;   // Cosine of the largest angle between coneAxis and a triangle normal
+};
+
+// Meshlets of one or more meshes; vertex entries are relative to the mesh's base vertex
+struct MeshletTables
+{
+	std::vector<Meshlet> meshlets;
+	std::vector<GLuint> vertices;       // Mesh vertices used by each meshlet
+	std::vector<GLubyte> triangles;     // Three meshlet-local vertex numbers per triangle
+};
+
+/* Splits an indexed triangle list into meshlets, appending them to the tables.
+ * Triangles are taken in index order, so running after the vertex cache optimizer keeps clusters compact.
+ * Returns the number of meshlets added.
+ */
+GLuint UBuildMeshlets(const GLuint* indices, GLuint nIndices, const GLfloat* verts, MeshletTables& tables);
+
+// Frustum planes (xyz normal pointing inside, w distance) of a view projection matrix
+void UExtractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+
+/* Conservative cluster culling for a meshlet placed by a model matrix.
+ * A meshlet is rejected only if its bounding sphere is outside a frustum plane,
+ * or every triangle in it faces away from the camera.
+ */
+bool UMeshletVisible(const Meshlet& meshlet, const glm::mat4& model, const glm::vec3& cameraPosition, const glm::vec4 planes[6]);
+
+/* Checks cluster culling against every triangle from a set of camera positions around the mesh.
+ * Returns the number of triangles that were visible but rejected with their meshlet (0 when culling is sound).
+ */
+GLuint UValidateMeshletCulling(const MeshletTables& tables, GLuint firstMeshlet, GLuint nMeshlets, const GLfloat* verts);
@@ -0,0 +1,241 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "occlusion.h"
+
+#include <algorithm>
+#include <cmath>
+
+// SSE2 is part of every x64 target, 32 bit builds fall back to scalar code without /arch:SSE2
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCCLUSION_USE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// Clip space w below which a point counts as crossing the near plane
+	const GLfloat OCCLUSION_NEAR_W = 1e-4f;
+
+	// Clip space to pixel coordinates, depth mapped from -1..1 to 0..1
+	glm::vec3 UToScreen(const glm::vec4& clip)
+	{
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		return glm::vec3((ndc.x * 0.5f + 0.5f) * OCCLUSION_WIDTH, (ndc.y * 0.5f + 0.5f) * OCCLUSION_HEIGHT, ndc.z * 0.5f + 0.5f);
+	}
+
+	// Edge function through a and b, positive to the left of a -> b
+	glm::vec3 UEdge(const glm::vec3& a, const glm::vec3& b)
+	{
+		return glm::vec3(a.y - b.y, b.x - a.x, a.x * b.y - a.y * b.x);
+	}
+}
+
+
+void OcclusionBuffer::CreateOcclusionBuffer(GLuint nThreads)
+{
+	gThreads = std::max(1u, std::min(nThreads, OCCLUSION_HEIGHT));
+	gDepth.assign(OCCLUSION_WIDTH * OCCLUSION_HEIGHT, 1.0f);
+	gViewProjection = glm::mat4(1.0f);
+	gTriangles = 0;
+	gWorkers.CreateWorkerPool(gThreads);
+}
+
+
+void OcclusionBuffer::DestroyOcclusionBuffer()
+{
+	gWorkers.DestroyWorkerPool();
+}
+
+
+void OcclusionBuffer::BeginFrame(const glm::mat4& viewProjection)
+{
+	std::fill(gDepth.begin(), gDepth.end(), 1.0f);
+	gViewProjection = viewProjection;
+	gScreenTriangles.clear();
+	gTriangles = 0;
+}
+
+
+void OcclusionBuffer::AddOccluder(const glm::vec3* positions, const GLuint* indices, GLuint nIndices, const glm::mat4& model)
+{
+	glm::mat4 modelViewProjection = gViewProjection * model;
+	for (GLuint i = 0; i + 2 < nIndices; i += 3)
+	{
+		glm::vec4 clip[3];
+		bool crossesNear = false;
+		for (GLuint corner = 0; corner < 3; ++corner)
+		{
+			clip[corner] = modelViewProjection * glm::vec4(positions[indices[i + corner]], 1.0f);
+			crossesNear |= clip[corner].w < OCCLUSION_NEAR_W;
+		}
+		if (crossesNear)
+			continue;
+
+		glm::vec3 v0 = UToScreen(clip[0]);
+		glm::vec3 v1 = UToScreen(clip[1]);
+		glm::vec3 v2 = UToScreen(clip[2]);
+
+		// Both facings occlude; clockwise triangles are flipped so the inside is positive
+		GLfloat area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+		if (area == 0.0f || std::isnan(area))
+			continue;
+		if (area < 0.0f)
+		{
+			std::swap(v1, v2);
+			area = -area;
+		}
+
+		ScreenTriangle triangle;
+		triangle.edges[0] = UEdge(v1, v2);
+		triangle.edges[1] = UEdge(v2, v0);
+		triangle.edges[2] = UEdge(v0, v1);
+		// Barycentric weights are the edge functions over the area
+		triangle.depth = (triangle.edges[0] * v0.z + triangle.edges[1] * v1.z + triangle.edges[2] * v2.z) / area;
+
+		// Conservative: an edge passes a pixel center only when all four corners of the pixel are inside,
+		// and the depth written is the farthest the plane gets over the pixel rather than its center depth
+		for (GLuint e = 0; e < 3; ++e)
+			triangle.edges[e].z -= 0.5f * (std::fabs(triangle.edges[e].x) + std::fabs(triangle.edges[e].y));
+		triangle.depth.z += 0.5f * (std::fabs(triangle.depth.x) + std::fabs(triangle.depth.y));
+
+		// Pixel centers sit at + 0.5; the bounds of the unshrunk triangle still hold every covered pixel
+		triangle.minX = std::max(0, (GLint)std::ceil(std::min(v0.x, std::min(v1.x, v2.x)) - 0.5f));
+		triangle.maxX = std::min((GLint)OCCLUSION_WIDTH - 1, (GLint)std::floor(std::max(v0.x, std::max(v1.x, v2.x)) - 0.5f));
+		triangle.minY = std::max(0, (GLint)std::ceil(std::min(v0.y, std::min(v1.y, v2.y)) - 0.5f));
+		triangle.maxY = std::min((GLint)OCCLUSION_HEIGHT - 1, (GLint)std::floor(std::max(v0.y, std::max(v1.y, v2.y)) - 0.5f));
+		if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+			continue;
+
+		gScreenTriangles.push_back(triangle);
+	}
+}
+
+
+void OcclusionBuffer::Rasterize()
+{
+	gTriangles = (GLuint)gScreenTriangles.size();
+
+	gWorkers.Run(gThreads, [this](GLuint band) { URasterizeBand(UBandStart(band), UBandStart(band + 1)); });
+}
+
+
+bool OcclusionBuffer::IsVisible(const BoundingBox& box) const
+{
+	glm::vec2 lower(1e30f);
+	glm::vec2 upper(-1e30f);
+	GLfloat nearest = 1.0f;
+	for (GLuint corner = 0; corner < 8; ++corner)
+	{
+		glm::vec3 position((corner & 1) ? box.upper.x : box.lower.x, (corner & 2) ? box.upper.y : box.lower.y, (corner & 4) ? box.upper.z : box.lower.z);
+		glm::vec4 clip = gViewProjection * glm::vec4(position, 1.0f);
+		// Boxes reaching behind the camera cannot be placed on screen
+		if (clip.w < OCCLUSION_NEAR_W)
+			return true;
+
+		glm::vec3 screen = UToScreen(clip);
+		lower = glm::min(lower, glm::vec2(screen.x, screen.y));
+		upper = glm::max(upper, glm::vec2(screen.x, screen.y));
+		nearest = std::min(nearest, screen.z);
+	}
+
+	// Every pixel the rectangle touches, even partly
+	GLint minX = std::max(0, (GLint)std::floor(lower.x));
+	GLint maxX = std::min((GLint)OCCLUSION_WIDTH - 1, (GLint)std::floor(upper.x));
+	GLint minY = std::max(0, (GLint)std::floor(lower.y));
+	GLint maxY = std::min((GLint)OCCLUSION_HEIGHT - 1, (GLint)std::floor(upper.y));
+	// Off screen, left to the frustum test
+	if (minX > maxX || minY > maxY)
+		return true;
+
+	for (GLint y = minY; y <= maxY; ++y)
+	{
+		const GLfloat* row = &gDepth[y * OCCLUSION_WIDTH];
+		GLint x = minX;
+#ifdef OCCLUSION_USE_SSE
+		__m128 boxDepth = _mm_set1_ps(nearest);
+		for (; x + 3 <= maxX; x += 4)
+		{
+			if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), boxDepth)) != 0)
+				return true;
+		}
+#endif
+		for (; x <= maxX; ++x)
+		{
+			if (row[x] >= nearest)
+				return true;
+		}
+	}
+	return false;
+}
+
+
+GLuint OcclusionBuffer::UBandStart(GLuint band) const
+{
+	return band * OCCLUSION_HEIGHT / gThreads;
+}
+
+
+void OcclusionBuffer::URasterizeBand(GLuint firstRow, GLuint endRow)
+{
+	for (const ScreenTriangle& triangle : gScreenTriangles)
+	{
+		GLint minY = std::max(triangle.minY, (GLint)firstRow);
+		GLint maxY = std::min(triangle.maxY, (GLint)endRow - 1);
+
+		for (GLint y = minY; y <= maxY; ++y)
+		{
+			GLfloat* row = &gDepth[y * OCCLUSION_WIDTH];
+			GLfloat centerY = (GLfloat)y + 0.5f;
+			GLint x = triangle.minX;
+
+#ifdef OCCLUSION_USE_SSE
+			// Four pixels per step, same arithmetic as the scalar loop so both write the same depths
+			const __m128 zero = _mm_setzero_ps();
+			__m128 edgeA[3], edgeRow[3];
+			for (GLuint e = 0; e < 3; ++e)
+			{
+				edgeA[e] = _mm_set1_ps(triangle.edges[e].x);
+				edgeRow[e] = _mm_set1_ps(triangle.edges[e].y * centerY);
+			}
+			__m128 edgeC[3] = { _mm_set1_ps(triangle.edges[0].z), _mm_set1_ps(triangle.edges[1].z), _mm_set1_ps(triangle.edges[2].z) };
+			__m128 depthA = _mm_set1_ps(triangle.depth.x);
+			__m128 depthRow = _mm_set1_ps(triangle.depth.y * centerY);
+			__m128 depthC = _mm_set1_ps(triangle.depth.z);
+
+			for (; x + 3 <= triangle.maxX; x += 4)
+			{
+				__m128 centerX = _mm_add_ps(_mm_cvtepi32_ps(_mm_setr_epi32(x, x + 1, x + 2, x + 3)), _mm_set1_ps(0.5f));
+				__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (GLuint e = 0; e < 3; ++e)
+				{
+					__m128 edge = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeA[e], centerX), edgeRow[e]), edgeC[e]);
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(edge, zero));
+				}
+				if (_mm_movemask_ps(inside) == 0)
+					continue;
+
+				__m128 depth = _mm_add_ps(_mm_add_ps(_mm_mul_ps(depthA, centerX), depthRow), depthC);
+				__m128 stored = _mm_loadu_ps(row + x);
+				__m128 nearer = _mm_min_ps(stored, depth);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, stored)));
+			}
+#endif
+			for (; x <= triangle.maxX; ++x)
+			{
+				GLfloat centerX = (GLfloat)x + 0.5f;
+				bool inside = true;
+				for (GLuint e = 0; e < 3; ++e)
+					inside &= triangle.edges[e].x * centerX + triangle.edges[e].y * centerY + triangle.edges[e].z >= 0.0f;
+				if (!inside)
+					continue;
+
+				GLfloat depth = triangle.depth.x * centerX + triangle.depth.y * centerY + triangle.depth.z;
+				row[x] = std::min(row[x], depth);
+			}
+		}
+	}
+}
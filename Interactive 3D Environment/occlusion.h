@@ -0,0 +1,73 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "bounds.h"
+#include "workerpool.h"
+
+// Resolution of the software depth buffer; objects are tested against it, never drawn into it
+const GLuint OCCLUSION_WIDTH = 256;
+const GLuint OCCLUSION_HEIGHT = 128;
+
+/* Low resolution depth buffer rasterized on the CPU from a few large occluders.
+ * Every frame: BeginFrame, AddOccluder for each occluder, Rasterize, then IsVisible for the other objects.
+ * Rows are split into bands, one per thread, so threads never write the same pixel. The threads are
+ * started by CreateOcclusionBuffer and kept until DestroyOcclusionBuffer.
+ */
+class OcclusionBuffer
+{
+public:
+	/* Occluder depth of each pixel, 0 at the near plane and 1 at the far plane; row 0 is the bottom of the view.
+	 * Only triangles covering a whole pixel write to it, with their farthest depth over that pixel, so a pixel
+	 * never claims more occlusion than it has. Edges shared by two triangles leave their pixels empty.
+	 */
+	std::vector<GLfloat> gDepth;
+	GLuint gThreads;
+	// Occluder triangles rasterized in the current frame
+	GLuint gTriangles;
+
+public:
+	// nThreads bands are rasterized in parallel, the calling thread takes one of them
+	void CreateOcclusionBuffer(GLuint nThreads);
+	void DestroyOcclusionBuffer();
+
+	// Clears the depth and the occluders of the last frame
+	void BeginFrame(const glm::mat4& viewProjection);
+
+	/* Queues the triangles of a mesh, positions in mesh units and indices relative to positions.
+	 * Triangles crossing the near plane are dropped, which only ever lets more objects through.
+	 */
+	void AddOccluder(const glm::vec3* positions, const GLuint* indices, GLuint nIndices, const glm::mat4& model);
+
+	void Rasterize();
+
+	// False when every pixel the box covers holds an occluder nearer than the box's nearest corner
+	bool IsVisible(const BoundingBox& box) const;
+
+private:
+	// Screen space triangle set up for rasterization
+	struct ScreenTriangle
+	{
+		glm::vec3 edges[3];     // a, b, c of each edge function a * x + b * y + c, positive at centers of fully covered pixels
+		glm::vec3 depth;        // Depth plane a * x + b * y + c, raised to the farthest depth over a pixel
+		GLint minX, maxX;       // Pixel columns and rows whose centers may be inside
+		GLint minY, maxY;
+	};
+
+	glm::mat4 gViewProjection;
+	std::vector<ScreenTriangle> gScreenTriangles;
+	WorkerPool gWorkers;
+
+	GLuint UBandStart(GLuint band) const;
+	void URasterizeBand(GLuint firstRow, GLuint endRow);
+};
@@ -0,0 +1,245 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "occlusionqueries.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <iostream>
+
+namespace
+{
+	// Boxes this close to the camera may be cut by the near plane and come back empty
+	const GLfloat OCCLUSION_QUERY_NEAR_MARGIN = 0.2f;
+
+	// Unit cube around the origin, drawn without culling so either facing counts
+	const GLfloat BOX_VERTICES[] =
+	{
+		-0.5f, -0.5f, -0.5f,
+		0.5f, -0.5f, -0.5f,
+		0.5f, 0.5f, -0.5f,
+		-0.5f, 0.5f, -0.5f,
+		-0.5f, -0.5f, 0.5f,
+		0.5f, -0.5f, 0.5f,
+		0.5f, 0.5f, 0.5f,
+		-0.5f, 0.5f, 0.5f
+	};
+	const GLuint BOX_INDICES[] =
+	{
+		0, 1, 2, 0, 2, 3,   // Back
+		4, 6, 5, 4, 7, 6,   // Front
+		0, 4, 5, 0, 5, 1,   // Bottom
+		3, 2, 6, 3, 6, 7,   // Top
+		0, 3, 7, 0, 7, 4,   // Left
+		1, 5, 6, 1, 6, 2    // Right
+	};
+
+	bool UContains(const BoundingBox& box, const glm::vec3& point, GLfloat margin)
+	{
+		for (GLuint axis = 0; axis < 3; ++axis)
+		{
+			if (point[axis] < box.lower[axis] - margin || point[axis] > box.upper[axis] + margin)
+				return false;
+		}
+		return true;
+	}
+}
+
+
+void OcclusionQueries::CreateOcclusionQueries(GLuint nObjects, UniformTable* boxProgram)
+{
+	// The conservative target lets the driver answer from coarse depth
+	gTarget = GLEW_VERSION_4_3 || GLEW_ARB_ES3_compatibility ? GL_ANY_SAMPLES_PASSED_CONSERVATIVE : GL_ANY_SAMPLES_PASSED;
+	gFrame = 0;
+
+	ObjectQuery initial;
+	initial.visible = true;
+	initial.query = 0;
+	initial.issuedFrame = 0;
+	initial.nDecided = 0;
+	initial.nextTestFrame = 0;
+	gObjects.assign(nObjects, initial);
+	// Spread the retests of visible objects over the interval
+	for (GLuint i = 0; i < nObjects; ++i)
+		gObjects[i].nextTestFrame = i % OCCLUSION_QUERY_INTERVAL;
+
+	gBoxProgram = boxProgram;
+	gBoxTransform = boxProgram->Find("boxTransform");
+
+	glGenVertexArrays(1, &gBoxVao);
+	glBindVertexArray(gBoxVao);
+	glGenBuffers(2, gBoxVbos);
+	glBindBuffer(GL_ARRAY_BUFFER, gBoxVbos[0]);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(BOX_VERTICES), BOX_VERTICES, GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 3, 0);
+	glEnableVertexAttribArray(0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gBoxVbos[1]);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(BOX_INDICES), BOX_INDICES, GL_STATIC_DRAW);
+	glBindVertexArray(0);
+
+	ResetCounters();
+	std::cout << "INFO: Occlusion queries use " << (gTarget == GL_ANY_SAMPLES_PASSED_CONSERVATIVE ? "GL_ANY_SAMPLES_PASSED_CONSERVATIVE" : "GL_ANY_SAMPLES_PASSED") << std::endl;
+}
+
+
+void OcclusionQueries::DestroyOcclusionQueries()
+{
+	for (ObjectQuery& object : gObjects)
+	{
+		if (object.query != 0)
+			gFreeQueries.push_back(object.query);
+		object.query = 0;
+	}
+	if (!gFreeQueries.empty())
+		glDeleteQueries((GLsizei)gFreeQueries.size(), gFreeQueries.data());
+	gFreeQueries.clear();
+
+	glDeleteVertexArrays(1, &gBoxVao);
+	glDeleteBuffers(2, gBoxVbos);
+}
+
+
+void OcclusionQueries::BeginFrame()
+{
+	++gFrame;
+	for (ObjectQuery& object : gObjects)
+	{
+		if (object.query == 0)
+			continue;
+
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(object.query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			continue;
+
+		GLuint anySamples = GL_FALSE;
+		glGetQueryObjectuiv(object.query, GL_QUERY_RESULT, &anySamples);
+		object.visible = anySamples != GL_FALSE;
+		if (!object.visible)
+			gSkipped += object.nDecided;
+
+		++gResults;
+		gLatencyFrames += gFrame - object.issuedFrame;
+		gFreeQueries.push_back(object.query);
+		object.query = 0;
+		object.nDecided = 0;
+	}
+}
+
+
+bool OcclusionQueries::WasVisible(GLuint object) const
+{
+	return gObjects[object].visible;
+}
+
+
+bool OcclusionQueries::BeginRetest(GLuint object)
+{
+	ObjectQuery& state = gObjects[object];
+	if (state.query != 0 || gFrame < state.nextTestFrame)
+		return false;
+
+	state.query = UAcquireQuery();
+	state.issuedFrame = gFrame;
+	state.nextTestFrame = gFrame + OCCLUSION_QUERY_INTERVAL;
+	glBeginQuery(gTarget, state.query);
+	return true;
+}
+
+
+void OcclusionQueries::EndQuery()
+{
+	glEndQuery(gTarget);
+}
+
+
+void OcclusionQueries::BeginBoxQueries(GLState& state)
+{
+	state.UseProgram(gBoxProgram->gProgram);
+	state.BindVertexArray(gBoxVao);
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+}
+
+
+void OcclusionQueries::QueryBox(GLuint object, const BoundingBox& box, const glm::vec3& cameraPosition)
+{
+	ObjectQuery& query = gObjects[object];
+	// The query from an earlier frame is still in flight, the conditional draw uses it
+	if (query.query != 0)
+		return;
+
+	// From inside the box its faces are clipped away, so the object is simply taken as visible
+	if (UContains(box, cameraPosition, OCCLUSION_QUERY_NEAR_MARGIN))
+	{
+		query.visible = true;
+		return;
+	}
+
+	gBoxProgram->Set(gBoxTransform, glm::translate((box.lower + box.upper) * 0.5f) * glm::scale(box.upper - box.lower));
+
+	query.query = UAcquireQuery();
+	query.issuedFrame = gFrame;
+	glBeginQuery(gTarget, query.query);
+	glDrawElements(GL_TRIANGLES, sizeof(BOX_INDICES) / sizeof(BOX_INDICES[0]), GL_UNSIGNED_INT, nullptr);
+	glEndQuery(gTarget);
+}
+
+
+void OcclusionQueries::EndBoxQueries()
+{
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glDepthMask(GL_TRUE);
+}
+
+
+void OcclusionQueries::BeginConditionalDraw(GLuint object)
+{
+	ObjectQuery& query = gObjects[object];
+	if (query.query == 0)
+		return;
+
+	// Without waiting, the GPU may draw anyway while the result is not in yet, so only a draw issued
+	// after the result arrived is sure to be dropped when it found no samples
+	GLuint available = GL_FALSE;
+	glGetQueryObjectuiv(query.query, GL_QUERY_RESULT_AVAILABLE, &available);
+	query.nDecided += available != GL_FALSE;
+	++gConditional;
+	glBeginConditionalRender(query.query, GL_QUERY_NO_WAIT);
+}
+
+
+void OcclusionQueries::EndConditionalDraw(GLuint object)
+{
+	if (gObjects[object].query != 0)
+		glEndConditionalRender();
+}
+
+
+void OcclusionQueries::ResetCounters()
+{
+	gIssued = 0;
+	gResults = 0;
+	gLatencyFrames = 0;
+	gConditional = 0;
+	gSkipped = 0;
+}
+
+
+GLuint OcclusionQueries::UAcquireQuery()
+{
+	++gIssued;
+	if (gFreeQueries.empty())
+	{
+		GLuint query;
+		glGenQueries(1, &query);
+		return query;
+	}
+
+	GLuint query = gFreeQueries.back();
+	gFreeQueries.pop_back();
+	return query;
+}
@@ -0,0 +1,87 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "bounds.h"
+#include "glstate.h"
+#include "uniforms.h"
+
+// Frames a visible object keeps its visibility before its draw is queried again
+const GLuint OCCLUSION_QUERY_INTERVAL = 8;
+
+/* Hardware occlusion queries with temporal coherence, after CHC++.
+ * Each object keeps the visibility its last query returned. Objects visible last frame draw first; every
+ * OCCLUSION_QUERY_INTERVAL frames their draw runs under a query. The bounding boxes of hidden objects are
+ * then queried against that depth and their draws are rendered conditionally on the result.
+ * Results are only read once available, so the CPU never waits on the GPU.
+ */
+class OcclusionQueries
+{
+public:
+	// Totals since the last ResetCounters
+	GLuint gIssued;         // Queries begun
+	GLuint gResults;        // Results read back
+	GLuint gLatencyFrames;  // Frames between issue and result, summed over gResults
+	GLuint gConditional;    // Draws rendered conditionally
+	GLuint gSkipped;        // Conditional draws issued after their query found no samples, so the GPU had to drop them
+
+public:
+	/* boxProgram draws the proxy boxes; it reads FrameBlock and a mat4 boxTransform that maps
+	 * the unit cube around the origin onto a box.
+	 */
+	void CreateOcclusionQueries(GLuint nObjects, UniformTable* boxProgram);
+	void DestroyOcclusionQueries();
+
+	// Reads every result that has arrived without waiting, then starts the next frame
+	void BeginFrame();
+
+	// Visibility of an object from its last query result; objects start out visible
+	bool WasVisible(GLuint object) const;
+
+	// Queries the draw of a visible object if it is due for a new test; returns whether EndQuery must follow the draw
+	bool BeginRetest(GLuint object);
+	void EndQuery();
+
+	// Proxy box queries of hidden objects, between BeginBoxQueries and EndBoxQueries which switch color and depth writes off
+	void BeginBoxQueries(GLState& state);
+	void QueryBox(GLuint object, const BoundingBox& box, const glm::vec3& cameraPosition);
+	void EndBoxQueries();
+
+	// Wraps the draw of a hidden object; without a query in flight the draw is unconditional
+	void BeginConditionalDraw(GLuint object);
+	void EndConditionalDraw(GLuint object);
+
+	void ResetCounters();
+
+private:
+	struct ObjectQuery
+	{
+		bool visible;
+		GLuint query;           // Query in flight, 0 if none
+		GLuint issuedFrame;
+		GLuint nDecided;        // Conditional draws issued once the result was available; earlier ones may have been drawn anyway
+		GLuint nextTestFrame;   // Visible objects are queried again from this frame on
+	};
+
+	GLenum gTarget;             // GL_ANY_SAMPLES_PASSED_CONSERVATIVE where supported
+	GLuint gFrame;
+	std::vector<ObjectQuery> gObjects;
+	std::vector<GLuint> gFreeQueries;
+
+	UniformTable* gBoxProgram;
+	GLint gBoxTransform;
+	GLuint gBoxVao;
+	GLuint gBoxVbos[2];
+
+	GLuint UAcquireQuery();
+};
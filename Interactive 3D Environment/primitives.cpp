@@ -0,0 +1,194 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "primitives.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const GLfloat TWO_PI = 6.28318530717958647692f;
+	const GLfloat PI = 3.14159265358979323846f;
+
+	// Writes one interleaved vertex and returns the next free slot
+	GLfloat* UWriteVertex(GLfloat* dst, GLfloat x, GLfloat y, GLfloat z, GLfloat nx, GLfloat ny, GLfloat nz, GLfloat u, GLfloat v)
+	{
+		dst[0] = x;  dst[1] = y;  dst[2] = z;
+		dst[3] = nx; dst[4] = ny; dst[5] = nz;
+		dst[6] = u;  dst[7] = v;
+		return dst + PRIMITIVE_FLOATS_PER_VERTEX;
+	}
+
+	// Writes one triangle and returns the next free slot
+	GLuint* UWriteTriangle(GLuint* dst, GLuint a, GLuint b, GLuint c)
+	{
+		dst[0] = a;
+		dst[1] = b;
+		dst[2] = c;
+		return dst + 3;
+	}
+}
+
+
+PrimitiveSize UCylinderSize(GLuint segments)
+{
+	PrimitiveSize size;
+	// Two caps (center + ring) plus the body, whose ring repeats its first column to close the texture seam
+	size.nVertices = 2 * (segments + 1) + 2 * (segments + 1);
+	// One triangle per cap segment plus a quad per body segment
+	size.nIndices = 3 * segments * 2 + 6 * segments;
+	return size;
+}
+
+
+PrimitiveSize USphereSize(GLuint segments, GLuint rings)
+{
+	PrimitiveSize size;
+	size.nVertices = (rings + 1) * (segments + 1);
+	// The top and bottom bands are single triangles meeting at the poles
+	size.nIndices = 6 * segments * (rings - 1);
+	return size;
+}
+
+
+// Cylinder of height 1 standing on the origin, ring vertices start on +x and wind toward -z
+PrimitiveSize UGenerateCylinder(GLuint segments, GLfloat bottomRadius, GLfloat topRadius, GLfloat* verts, GLuint* indices, GLuint baseVertex)
+{
+	GLfloat* v = verts;
+	GLuint* i = indices;
+
+	// Slope of the body so cones get lit correctly
+	const GLfloat slope = bottomRadius - topRadius;
+	const GLfloat normalLength = std::sqrt(1.0f + slope * slope);
+
+	const GLuint bottomCenter = baseVertex;
+	const GLuint topCenter = bottomCenter + segments + 1;
+	const GLuint body = topCenter + segments + 1;
+
+	// cylinder bottom
+	v = UWriteVertex(v, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.5f, 0.5f);
+	for (GLuint s = 0; s < segments; ++s)
+	{
+		GLfloat angle = TWO_PI * s / segments;
+		GLfloat c = std::cos(angle);
+		GLfloat n = std::sin(angle);
+		v = UWriteVertex(v, bottomRadius * c, 0.0f, -bottomRadius * n, 0.0f, -1.0f, 0.0f, 0.5f - 0.5f * n, 0.5f + 0.5f * c);
+		i = UWriteTriangle(i, bottomCenter, bottomCenter + 1 + (s + 1) % segments, bottomCenter + 1 + s);
+	}
+
+	// cylinder top
+	v = UWriteVertex(v, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.5f, 0.5f);
+	for (GLuint s = 0; s < segments; ++s)
+	{
+		GLfloat angle = TWO_PI * s / segments;
+		GLfloat c = std::cos(angle);
+		GLfloat n = std::sin(angle);
+		v = UWriteVertex(v, topRadius * c, 1.0f, -topRadius * n, 0.0f, 1.0f, 0.0f, 0.5f - 0.5f * n, 0.5f + 0.5f * c);
+		i = UWriteTriangle(i, topCenter, topCenter + 1 + s, topCenter + 1 + (s + 1) % segments);
+	}
+
+	// cylinder body, stored as bottom / top pairs
+	for (GLuint s = 0; s <= segments; ++s)
+	{
+		GLfloat angle = TWO_PI * s / segments;
+		GLfloat c = std::cos(angle);
+		GLfloat n = std::sin(angle);
+		GLfloat u = (GLfloat)s / segments;
+		GLfloat nx = c / normalLength;
+		GLfloat ny = slope / normalLength;
+		GLfloat nz = -n / normalLength;
+		v = UWriteVertex(v, bottomRadius * c, 0.0f, -bottomRadius * n, nx, ny, nz, u, 0.0f);
+		v = UWriteVertex(v, topRadius * c, 1.0f, -topRadius * n, nx, ny, nz, u, 1.0f);
+
+		if (s < segments)
+		{
+			GLuint b0 = body + 2 * s;
+			GLuint t0 = b0 + 1;
+			GLuint b1 = b0 + 2;
+			GLuint t1 = b0 + 3;
+			i = UWriteTriangle(i, b0, b1, t0);
+			i = UWriteTriangle(i, t0, b1, t1);
+		}
+	}
+
+	PrimitiveSize size;
+	size.nVertices = (GLuint)((v - verts) / PRIMITIVE_FLOATS_PER_VERTEX);
+	size.nIndices = (GLuint)(i - indices);
+	return size;
+}
+
+
+// Unit sphere centered on the origin, texture coords match the atan2 mapping of the original sphere
+PrimitiveSize UGenerateSphere(GLuint segments, GLuint rings, GLfloat* verts, GLuint* indices, GLuint baseVertex)
+{
+	GLfloat* v = verts;
+	GLuint* i = indices;
+	const GLuint columns = segments + 1;
+
+	for (GLuint r = 0; r <= rings; ++r)
+	{
+		GLfloat polar = PI * r / rings;
+		GLfloat y = std::cos(polar);
+		GLfloat ringRadius = std::sin(polar);
+
+		for (GLuint s = 0; s <= segments; ++s)
+		{
+			// Runs from -PI to PI so u equals atan2(x, z) / (2 * PI) + 0.5 without a wrap at the seam
+			GLfloat azimuth = -PI + TWO_PI * s / segments;
+			GLfloat x = ringRadius * std::sin(azimuth);
+			GLfloat z = ringRadius * std::cos(azimuth);
+			v = UWriteVertex(v, x, y, z, x, y, z, (GLfloat)s / segments, y * 0.5f + 0.5f);
+		}
+	}
+
+	for (GLuint r = 0; r < rings; ++r)
+	{
+		for (GLuint s = 0; s < segments; ++s)
+		{
+			GLuint a = baseVertex + r * columns + s;
+			GLuint b = a + columns;
+			GLuint c = a + 1;
+			GLuint d = b + 1;
+
+			// Skip the degenerate half of each quad touching a pole
+			if (r != 0)
+				i = UWriteTriangle(i, a, b, c);
+			if (r != rings - 1)
+				i = UWriteTriangle(i, c, b, d);
+		}
+	}
+
+	PrimitiveSize size;
+	size.nVertices = (GLuint)((v - verts) / PRIMITIVE_FLOATS_PER_VERTEX);
+	size.nIndices = (GLuint)(i - indices);
+	return size;
+}
+
+
+PrimitiveSize UPrimitiveSize(const PrimitiveDesc& desc)
+{
+	if (desc.shape == PRIMITIVE_SPHERE)
+		return USphereSize(desc.segments, desc.rings);
+	return UCylinderSize(desc.segments);
+}
+
+
+GLfloat UPrimitiveError(const PrimitiveDesc& desc)
+{
+	// Sagitta of the chord between two neighbouring segments (or rings)
+	if (desc.shape == PRIMITIVE_SPHERE)
+		return 1.0f - std::cos(PI / std::min(desc.segments, 2 * desc.rings));
+	return std::max(desc.bottomRadius, desc.topRadius) * (1.0f - std::cos(PI / desc.segments));
+}
+
+
+PrimitiveSize UGeneratePrimitive(const PrimitiveDesc& desc, GLfloat* verts, GLuint* indices, GLuint baseVertex)
+{
+	if (desc.shape == PRIMITIVE_SPHERE)
+		return UGenerateSphere(desc.segments, desc.rings, verts, indices, baseVertex);
+	return UGenerateCylinder(desc.segments, desc.bottomRadius, desc.topRadius, verts, indices, baseVertex);
+}
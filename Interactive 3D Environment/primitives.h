@@ -0,0 +1,61 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+// Floats per interleaved vertex: position (3), normal (3), texture coords (2)
+const GLuint PRIMITIVE_FLOATS_PER_VERTEX = 8;
+
+// Number of detail levels generated for each parametric primitive
+const GLuint PRIMITIVE_LOD_COUNT = 3;
+
+// Vertex and index counts of a generated primitive
+struct PrimitiveSize
+{
+	GLuint nVertices;   // Number of interleaved vertices written
+	GLuint nIndices;    // Number of triangle list indices written
+};
+
+// Segment / ring counts used for each detail level (level 0 is the most detailed)
+const GLuint CYLINDER_LOD_SEGMENTS[PRIMITIVE_LOD_COUNT] = { 36, 18, 8 };
+const GLuint SPHERE_LOD_SEGMENTS[PRIMITIVE_LOD_COUNT] = { 16, 12, 8 };
+const GLuint SPHERE_LOD_RINGS[PRIMITIVE_LOD_COUNT] = { 16, 10, 6 };
+
+// Shapes the generator can build
+enum PrimitiveShape
+{
+	PRIMITIVE_CYLINDER,     // Also cones, through a different top radius
+	PRIMITIVE_SPHERE
+};
+
+// Parameters of one generated primitive (or one detail level of it)
+struct PrimitiveDesc
+{
+	PrimitiveShape shape;
+	GLuint segments;        // Subdivisions around the y axis
+	GLuint rings;           // Latitude bands (spheres only)
+	GLfloat bottomRadius;   // Cylinders only
+	GLfloat topRadius;      // Cylinders only
+};
+
+/* Size queries so callers can allocate the destination buffers up front */
+PrimitiveSize UCylinderSize(GLuint segments);
+PrimitiveSize USphereSize(GLuint segments, GLuint rings);
+
+/* Generators write interleaved vertices and triangle list indices into caller-provided buffers.
+ * baseVertex is added to every index so several primitives (or detail levels) can share one buffer.
+ * A cone is a cylinder with a different top radius.
+ */
+PrimitiveSize UGenerateCylinder(GLuint segments, GLfloat bottomRadius, GLfloat topRadius, GLfloat* verts, GLuint* indices, GLuint baseVertex = 0);
+PrimitiveSize UGenerateSphere(GLuint segments, GLuint rings, GLfloat* verts, GLuint* indices, GLuint baseVertex = 0);
+
+// Dispatch on the shape of a description
+PrimitiveSize UPrimitiveSize(const PrimitiveDesc& desc);
+// Largest distance between the tessellation and the exact surface, in mesh units
+GLfloat UPrimitiveError(const PrimitiveDesc& desc);
+PrimitiveSize UGeneratePrimitive(const PrimitiveDesc& desc, GLfloat* verts, GLuint* indices, GLuint baseVertex = 0);
@@ -0,0 +1,757 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "renderqueue.h"
+
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace
+{
+	DrawRecord UDrawRecord(const glm::mat4& model, const glm::mat3& normalMatrix, const Meshes::GLMesh& mesh, const glm::vec2& uvScale, GLuint material)
+	{
+		DrawRecord record;
+		record.model = model;
+		for (GLuint column = 0; column < 3; ++column)
+			record.normalMatrix[column] = glm::vec4(normalMatrix[column], 0.0f);
+		record.positionOffset = glm::vec4(mesh.positionOffset, 0.0f);
+		record.positionScale = glm::vec4(mesh.positionScale, 0.0f);
+		record.uvScale = uvScale;
+		record.material = material;
+		record.padding = 0;
+		return record;
+	}
+
+	// Least significant digit first, one byte per pass, stable so earlier bytes keep their order
+	template <typename KeyOf>
+	void URadixSort(std::vector<GLuint>& order, std::vector<GLuint>& scratch, KeyOf keyOf)
+	{
+		GLuint n = (GLuint)order.size();
+		if (n == 0)
+			return;
+
+		scratch.resize(n);
+		for (GLuint shift = 0; shift < 64; shift += 8)
+		{
+			GLuint counts[256] = {};
+			for (GLuint index : order)
+				++counts[(keyOf(index) >> shift) & 0xFF];
+
+			// Every key shares this byte, the pass would not move anything
+			if (counts[(keyOf(order[0]) >> shift) & 0xFF] == n)
+				continue;
+
+			GLuint offset = 0;
+			for (GLuint digit = 0; digit < 256; ++digit)
+			{
+				GLuint count = counts[digit];
+				counts[digit] = offset;
+				offset += count;
+			}
+			for (GLuint index : order)
+				scratch[counts[(keyOf(index) >> shift) & 0xFF]++] = index;
+			order.swap(scratch);
+		}
+	}
+}
+
+DrawUniforms UFindDrawUniforms(const UniformTable& program)
+{
+	DrawUniforms uniforms;
+	uniforms.model = program.Find("model");
+	uniforms.normalMatrix = program.Find("normalMatrix");
+	uniforms.positionOffset = program.Find("positionOffset");
+	uniforms.positionScale = program.Find("positionScale");
+	uniforms.uvScale = program.Find("uvScale");
+	uniforms.material = program.Find("materialId");
+	uniforms.useDrawRecords = program.Find("useDrawRecords");
+	uniforms.useInstances = program.Find("useInstances");
+	return uniforms;
+}
+
+
+glm::mat3 UNormalMatrix(const SceneObject& object)
+{
+	// The inverse transpose of a rotation is the rotation, that of a scale is its reciprocal
+	glm::mat3 normalMatrix = glm::mat3(glm::rotate(object.rotationAngle, object.rotationAxis));
+	normalMatrix[0] /= object.scale.x;
+	normalMatrix[1] /= object.scale.y;
+	normalMatrix[2] /= object.scale.z;
+	return normalMatrix;
+}
+
+
+glm::mat3 UNormalMatrix(const glm::mat4& model)
+{
+	return glm::transpose(glm::inverse(glm::mat3(model)));
+}
+
+
+void RenderQueue::SetScene(const SceneObject* scene, GLuint nObjects)
+{
+	gObjects.resize(nObjects);
+	gBounds.Resize(nObjects);
+	gPackets.reserve(nObjects);
+
+	for (GLuint i = 0; i < nObjects; ++i)
+	{
+		const SceneObject& source = scene[i];
+		RenderObject& object = gObjects[i];
+
+		object.mesh = source.mesh;
+		object.material = source.material;
+		object.uvScale = source.uvScale;
+		object.occluder = source.occluder;
+
+		// Model matrix: transformations are applied right-to-left order
+		object.model = glm::translate(source.translation) * glm::rotate(source.rotationAngle, source.rotationAxis) * glm::scale(source.scale);
+		object.normalMatrix = UNormalMatrix(source);
+
+		object.worldBox = UTransformBox(source.mesh->box, object.model);
+		object.worldSphere = UTransformSphere(source.mesh->sphere, object.model);
+		gBounds.Set(i, object.worldBox, object.worldSphere);
+		object.worldScale = std::max(glm::length(glm::vec3(object.model[0])),
+			std::max(glm::length(glm::vec3(object.model[1])), glm::length(glm::vec3(object.model[2]))));
+	}
+}
+
+
+void RenderQueue::RasterizeOccluders(const Meshes& meshes, const glm::mat4& viewProjection, OcclusionBuffer& occlusion) const
+{
+	occlusion.BeginFrame(viewProjection);
+	for (const RenderObject& object : gObjects)
+	{
+		// Simplified levels may bulge past the surface, only the authored one is safe to hide objects with
+		if (object.occluder)
+		{
+			const Meshes::GLMeshLod& lod = object.mesh->lods[0];
+			occlusion.AddOccluder(&meshes.gPositions[object.mesh->baseVertex], &meshes.gIndices[object.mesh->firstIndex + lod.firstIndex],
+				lod.nIndices, object.model);
+		}
+	}
+	occlusion.Rasterize();
+}
+
+
+void RenderQueue::BuildPackets(const Meshes& meshes, const Material* materials, const RenderView& view)
+{
+	gPackets.clear();
+	gOrder.clear();
+
+	GLuint nObjects = (GLuint)gObjects.size();
+	gCulled = nObjects - UCullBounds(view.frustum, gBounds, gVisible);
+	gOccluded = 0;
+
+	for (GLuint i = 0; i < nObjects; ++i)
+	{
+		if (!gVisible[i])
+			continue;
+
+		const RenderObject& object = gObjects[i];
+		// Occluders would only be tested against themselves
+		if (view.occlusion && !object.occluder && !view.occlusion->IsVisible(object.worldBox))
+		{
+			++gOccluded;
+			continue;
+		}
+		DrawPacket packet;
+		UMakePacket(meshes, materials, view, i, packet);
+
+		gOrder.push_back((GLuint)gPackets.size());
+		gPackets.push_back(packet);
+	}
+}
+
+
+void RenderQueue::Sort(const Material* materials)
+{
+	gStateChangesUnsorted = UCountStateChanges(materials, gOrder);
+	URadixSort(gOrder, gScratch, [this](GLuint index) { return gPackets[index].sortKey; });
+	gStateChangesSorted = UCountStateChanges(materials, gOrder);
+}
+
+
+void RenderQueue::Submit(const Material* materials, GLState& state)
+{
+	for (GLuint index : gOrder)
+		UDrawPacket(materials, gPackets[index], state);
+	gDrawCalls = (GLuint)gOrder.size();
+}
+
+
+void RenderQueue::SubmitQueried(const Material* materials, GLState& state, OcclusionQueries& queries, const glm::vec3& cameraPosition)
+{
+	queries.BeginFrame();
+
+	// Objects visible last frame fill the depth buffer, now and then with their draw under a query
+	for (GLuint index : gOrder)
+	{
+		const DrawPacket& packet = gPackets[index];
+		if (!queries.WasVisible(packet.object))
+			continue;
+
+		bool retest = queries.BeginRetest(packet.object);
+		UDrawPacket(materials, packet, state);
+		if (retest)
+			queries.EndQuery();
+	}
+
+	// The boxes of the others are tested against that depth
+	queries.BeginBoxQueries(state);
+	for (GLuint index : gOrder)
+	{
+		const DrawPacket& packet = gPackets[index];
+		if (!queries.WasVisible(packet.object))
+			queries.QueryBox(packet.object, gObjects[packet.object].worldBox, cameraPosition);
+	}
+	queries.EndBoxQueries();
+
+	// and drawn only if the GPU finds their box uncovered
+	for (GLuint index : gOrder)
+	{
+		const DrawPacket& packet = gPackets[index];
+		if (queries.WasVisible(packet.object))
+			continue;
+
+		queries.BeginConditionalDraw(packet.object);
+		UDrawPacket(materials, packet, state);
+		queries.EndConditionalDraw(packet.object);
+	}
+	gDrawCalls = (GLuint)gOrder.size();
+}
+
+
+void RenderQueue::CreateIndirectBuffers(const Meshes& meshes)
+{
+	glGenBuffers(1, &gIndirectBuffer);
+	glGenBuffers(1, &gRecordBuffer);
+	glGenBuffers(1, &gObjectRecordBuffer);
+	glGenBuffers(1, &gDrawIndexBuffer);
+	gDrawIndexCapacity = 0;
+	gIndirectVao = meshes.CreateVertexArray();
+
+	// Instanced attribute: with one instance per command, each draw reads the value at its baseInstance
+	glBindVertexArray(gIndirectVao);
+	glBindBuffer(GL_ARRAY_BUFFER, gDrawIndexBuffer);
+	glVertexAttribIPointer(DRAW_INDEX_ATTRIBUTE, 1, GL_UNSIGNED_INT, sizeof(GLuint), 0);
+	glVertexAttribDivisor(DRAW_INDEX_ATTRIBUTE, 1);
+	glEnableVertexAttribArray(DRAW_INDEX_ATTRIBUTE);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// The attribute points at storage before the first reservation of a frame
+	UReserveDrawIndices(1);
+}
+
+
+void RenderQueue::DestroyIndirectBuffers()
+{
+	glDeleteVertexArrays(1, &gIndirectVao);
+	glDeleteBuffers(1, &gIndirectBuffer);
+	glDeleteBuffers(1, &gRecordBuffer);
+	glDeleteBuffers(1, &gObjectRecordBuffer);
+	glDeleteBuffers(1, &gDrawIndexBuffer);
+}
+
+
+void RenderQueue::CreateInstanceBuffers(const Meshes& meshes)
+{
+	glGenBuffers(1, &gInstanceBuffer);
+	gInstancedVao = meshes.CreateVertexArray();
+
+	// Columns of the matrices take one location each, every attribute advances once per instance
+	glBindVertexArray(gInstancedVao);
+	glBindBuffer(GL_ARRAY_BUFFER, gInstanceBuffer);
+	GLint stride = sizeof(InstanceAttributes);
+	for (GLuint column = 0; column < 4; ++column)
+	{
+		glVertexAttribPointer(INSTANCE_ATTRIBUTE + column, 4, GL_FLOAT, GL_FALSE, stride, (void*)(offsetof(InstanceAttributes, model) + sizeof(glm::vec4) * column));
+		glVertexAttribDivisor(INSTANCE_ATTRIBUTE + column, 1);
+		glEnableVertexAttribArray(INSTANCE_ATTRIBUTE + column);
+	}
+	for (GLuint column = 0; column < 3; ++column)
+	{
+		glVertexAttribPointer(INSTANCE_ATTRIBUTE + 4 + column, 3, GL_FLOAT, GL_FALSE, stride, (void*)(offsetof(InstanceAttributes, normalMatrix) + sizeof(glm::vec3) * column));
+		glVertexAttribDivisor(INSTANCE_ATTRIBUTE + 4 + column, 1);
+		glEnableVertexAttribArray(INSTANCE_ATTRIBUTE + 4 + column);
+	}
+	glVertexAttribPointer(INSTANCE_ATTRIBUTE + 7, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(InstanceAttributes, uvScale));
+	glVertexAttribDivisor(INSTANCE_ATTRIBUTE + 7, 1);
+	glEnableVertexAttribArray(INSTANCE_ATTRIBUTE + 7);
+	glVertexAttribIPointer(INSTANCE_ATTRIBUTE + 8, 1, GL_UNSIGNED_INT, stride, (void*)offsetof(InstanceAttributes, material));
+	glVertexAttribDivisor(INSTANCE_ATTRIBUTE + 8, 1);
+	glEnableVertexAttribArray(INSTANCE_ATTRIBUTE + 8);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
+void RenderQueue::DestroyInstanceBuffers()
+{
+	glDeleteVertexArrays(1, &gInstancedVao);
+	glDeleteBuffers(1, &gInstanceBuffer);
+}
+
+
+void RenderQueue::SubmitInstanced(const Material* materials, GLState& state)
+{
+	GLuint nDraws = (GLuint)gOrder.size();
+	gDrawCalls = 0;
+	gInstancesMerged = 0;
+	if (nDraws == 0)
+		return;
+
+	// Assign every packet to a batch; batches of one material run are only searched while the run lasts
+	gBatches.clear();
+	gPacketBatches.resize(nDraws);
+	GLuint runStart = 0;
+	for (GLuint i = 0; i < nDraws; ++i)
+	{
+		const DrawPacket& packet = gPackets[gOrder[i]];
+		if (i > 0 && gPackets[gOrder[i - 1]].material != packet.material)
+			runStart = (GLuint)gBatches.size();
+
+		GLuint batch = runStart;
+		if (materials[packet.material].pass == RENDER_PASS_TRANSPARENT && gBatches.size() > runStart)
+			batch = (GLuint)gBatches.size() - 1;
+		while (batch < gBatches.size() && (gPackets[gBatches[batch].packet].mesh != packet.mesh || gPackets[gBatches[batch].packet].firstIndex != packet.firstIndex))
+			++batch;
+		if (batch == gBatches.size())
+		{
+			InstanceBatch newBatch;
+			newBatch.packet = gOrder[i];
+			newBatch.firstInstance = 0;
+			newBatch.nInstances = 0;
+			gBatches.push_back(newBatch);
+		}
+		++gBatches[batch].nInstances;
+		gPacketBatches[i] = batch;
+	}
+
+	// Instances of a batch sit next to each other, in submission order
+	GLuint firstInstance = 0;
+	for (InstanceBatch& batch : gBatches)
+	{
+		batch.firstInstance = firstInstance;
+		firstInstance += batch.nInstances;
+		batch.nInstances = 0;
+	}
+	gInstances.resize(nDraws);
+	for (GLuint i = 0; i < nDraws; ++i)
+	{
+		const DrawPacket& packet = gPackets[gOrder[i]];
+		InstanceBatch& batch = gBatches[gPacketBatches[i]];
+
+		InstanceAttributes& instance = gInstances[batch.firstInstance + batch.nInstances++];
+		instance.model = *packet.model;
+		instance.normalMatrix = *packet.normalMatrix;
+		instance.uvScale = packet.uvScale;
+		instance.material = packet.material;
+	}
+
+	// Respecified each frame like the indirect buffers
+	glBindBuffer(GL_ARRAY_BUFFER, gInstanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(InstanceAttributes) * nDraws, gInstances.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	for (const InstanceBatch& batch : gBatches)
+	{
+		const DrawPacket& packet = gPackets[batch.packet];
+		const Material& material = materials[packet.material];
+		state.UseProgram(material.program->gProgram);
+		state.BindVertexArray(gInstancedVao);
+
+		UniformTable& uniforms = *material.program;
+		uniforms.Set(material.uniforms.useDrawRecords, (GLint)false);
+		uniforms.Set(material.uniforms.useInstances, (GLint)true);
+		uniforms.Set(material.uniforms.positionOffset, packet.mesh->positionOffset);
+		uniforms.Set(material.uniforms.positionScale, packet.mesh->positionScale);
+
+		// baseInstance picks the batch's range of the instance buffer
+		glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, packet.nIndices, GL_UNSIGNED_INT, (void*)(sizeof(GLuint) * packet.firstIndex),
+			batch.nInstances, packet.mesh->baseVertex, batch.firstInstance);
+		++gDrawCalls;
+	}
+	gInstancesMerged = nDraws - gDrawCalls;
+}
+
+
+void RenderQueue::SubmitIndirect(const Material* materials, GLState& state)
+{
+	GLuint nDraws = (GLuint)gOrder.size();
+	gCommands.resize(nDraws);
+	gRecords.resize(nDraws);
+	gVaos.resize(nDraws);
+	for (GLuint i = 0; i < nDraws; ++i)
+	{
+		const DrawPacket& packet = gPackets[gOrder[i]];
+
+		DrawElementsIndirectCommand& command = gCommands[i];
+		command.count = packet.nIndices;
+		command.instanceCount = 1;
+		command.firstIndex = packet.firstIndex;
+		command.baseVertex = packet.mesh->baseVertex;
+		command.baseInstance = i;
+
+		gRecords[i] = UDrawRecord(*packet.model, *packet.normalMatrix, *packet.mesh, packet.uvScale, packet.material);
+		gVaos[i] = packet.vao;
+	}
+
+	USubmitCommands(materials, state, gCommands.data(), gRecords.data(), gVaos.data(), nDraws);
+}
+
+
+void RenderQueue::CreateCommandBuffers(GLuint nThreads)
+{
+	gCommandBuffers.resize(std::max(1u, nThreads));
+	gRecordingThreads.CreateWorkerPool((GLuint)gCommandBuffers.size());
+}
+
+
+void RenderQueue::DestroyCommandBuffers()
+{
+	gRecordingThreads.DestroyWorkerPool();
+	gCommandBuffers.clear();
+}
+
+
+void RenderQueue::RecordCommands(const Meshes& meshes, const Material* materials, const RenderView& view)
+{
+	// Without CreateCommandBuffers everything is recorded on the calling thread
+	if (gCommandBuffers.empty())
+		CreateCommandBuffers(1);
+	GLuint nObjects = (GLuint)gObjects.size();
+	GLuint nThreads = (GLuint)gCommandBuffers.size();
+	gVisible.resize(nObjects);
+
+	// Contiguous ranges keep each buffer's draws in object order, as BuildPackets would emit them
+	gRecordingThreads.Run(nThreads, [&](GLuint t)
+	{
+		URecordRange(meshes, materials, view, t * nObjects / nThreads, (t + 1) * nObjects / nThreads, gCommandBuffers[t]);
+	});
+
+	// Merge in thread order, then sort by key with the stable sort of Sort, so ties keep object order
+	gMerged.sortKeys.clear();
+	gMerged.vaos.clear();
+	gMerged.commands.clear();
+	gMerged.records.clear();
+	gCulled = 0;
+	gOccluded = 0;
+	for (const CommandBuffer& buffer : gCommandBuffers)
+	{
+		gMerged.sortKeys.insert(gMerged.sortKeys.end(), buffer.sortKeys.begin(), buffer.sortKeys.end());
+		gMerged.vaos.insert(gMerged.vaos.end(), buffer.vaos.begin(), buffer.vaos.end());
+		gMerged.commands.insert(gMerged.commands.end(), buffer.commands.begin(), buffer.commands.end());
+		gMerged.records.insert(gMerged.records.end(), buffer.records.begin(), buffer.records.end());
+		gCulled += buffer.culled;
+		gOccluded += buffer.occluded;
+	}
+
+	GLuint nDraws = (GLuint)gMerged.sortKeys.size();
+	gMergedOrder.resize(nDraws);
+	for (GLuint i = 0; i < nDraws; ++i)
+		gMergedOrder[i] = i;
+	URadixSort(gMergedOrder, gScratch, [this](GLuint index) { return gMerged.sortKeys[index]; });
+
+	gRecorded.sortKeys.resize(nDraws);
+	gRecorded.vaos.resize(nDraws);
+	gRecorded.commands.resize(nDraws);
+	gRecorded.records.resize(nDraws);
+	gRecorded.culled = gCulled;
+	gRecorded.occluded = gOccluded;
+	for (GLuint i = 0; i < nDraws; ++i)
+	{
+		GLuint source = gMergedOrder[i];
+		gRecorded.sortKeys[i] = gMerged.sortKeys[source];
+		gRecorded.vaos[i] = gMerged.vaos[source];
+		gRecorded.commands[i] = gMerged.commands[source];
+		gRecorded.commands[i].baseInstance = i;
+		gRecorded.records[i] = gMerged.records[source];
+	}
+}
+
+
+void RenderQueue::SubmitRecorded(const Material* materials, GLState& state)
+{
+	USubmitCommands(materials, state, gRecorded.commands.data(), gRecorded.records.data(), gRecorded.vaos.data(), (GLuint)gRecorded.commands.size());
+}
+
+
+void RenderQueue::UploadGpuScene(const Meshes& meshes, const Material* materials, GpuCulling& culling)
+{
+	GLuint nObjects = (GLuint)gObjects.size();
+
+	// Groups in order of first appearance, each object placed after the ones of its group before it
+	std::vector<GpuCulling::DrawGroup> groups;
+	std::vector<GLuint> objectGroups(nObjects);
+	for (GLuint i = 0; i < nObjects; ++i)
+	{
+		const RenderObject& object = gObjects[i];
+		GLuint program = materials[object.material].program->gProgram;
+		GLuint group = 0;
+		while (group < groups.size() && (materials[groups[group].material].program->gProgram != program || groups[group].vao != gIndirectVao))
+			++group;
+		if (group == groups.size())
+		{
+			GpuCulling::DrawGroup drawGroup;
+			drawGroup.firstCommand = 0;
+			drawGroup.nObjects = 0;
+			drawGroup.material = object.material;
+			drawGroup.vao = gIndirectVao;
+			groups.push_back(drawGroup);
+		}
+		++groups[group].nObjects;
+		objectGroups[i] = group;
+	}
+	GLuint firstCommand = 0;
+	for (GpuCulling::DrawGroup& group : groups)
+	{
+		group.firstCommand = firstCommand;
+		firstCommand += group.nObjects;
+	}
+
+	// Bounds as the CPU frustum test reads them, detail chains shared by every object of a mesh
+	std::vector<GpuCullObject> cullObjects(nObjects);
+	std::vector<GpuCullMesh> cullMeshes;
+	std::vector<const Meshes::GLMesh*> meshList;
+	std::vector<DrawRecord> records(nObjects);
+	for (GLuint i = 0; i < nObjects; ++i)
+	{
+		const RenderObject& object = gObjects[i];
+		GpuCullObject& cullObject = cullObjects[i];
+		cullObject.sphere = glm::vec4(gBounds.gSphereX[i], gBounds.gSphereY[i], gBounds.gSphereZ[i], gBounds.gRadius[i]);
+		cullObject.boxCenter = glm::vec4(gBounds.gBoxX[i], gBounds.gBoxY[i], gBounds.gBoxZ[i], 0.0f);
+		cullObject.boxExtent = glm::vec4(gBounds.gExtentX[i], gBounds.gExtentY[i], gBounds.gExtentZ[i], object.worldScale);
+		cullObject.group = objectGroups[i];
+		cullObject.padding[0] = 0;
+		cullObject.padding[1] = 0;
+
+		GLuint mesh = (GLuint)(std::find(meshList.begin(), meshList.end(), object.mesh) - meshList.begin());
+		if (mesh == meshList.size())
+		{
+			GpuCullMesh cullMesh = {};
+			cullMesh.baseVertex = object.mesh->baseVertex;
+			cullMesh.nLods = object.mesh->nLods;
+			for (GLuint lod = 0; lod < object.mesh->nLods; ++lod)
+			{
+				cullMesh.lods[lod].firstIndex = object.mesh->firstIndex + object.mesh->lods[lod].firstIndex;
+				cullMesh.lods[lod].nIndices = object.mesh->lods[lod].nIndices;
+				cullMesh.lods[lod].error = object.mesh->lods[lod].error;
+			}
+			meshList.push_back(object.mesh);
+			cullMeshes.push_back(cullMesh);
+		}
+		cullObject.mesh = mesh;
+
+		records[i] = UDrawRecord(object.model, object.normalMatrix, *object.mesh, object.uvScale, object.material);
+	}
+	culling.SetScene(cullObjects, cullMeshes, groups);
+
+	// Commands carry the object index in baseInstance, so the draw index buffer must reach every object
+	UReserveDrawIndices(std::max(nObjects, 1u));
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, gObjectRecordBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(DrawRecord) * nObjects, records.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+
+void RenderQueue::SubmitGpuCulled(const Material* materials, GLState& state, GpuCulling& culling, const RenderView& view)
+{
+	culling.Cull(state, view.frustum, view.cameraPosition, view.perspective, view.unitsPerPixel, view.pixelError);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_RECORD_BINDING, gObjectRecordBuffer);
+	for (GLuint group = 0; group < culling.gGroups.size(); ++group)
+	{
+		const Material& material = materials[culling.gGroups[group].material];
+		state.UseProgram(material.program->gProgram);
+		state.BindVertexArray(culling.gGroups[group].vao);
+		material.program->Set(material.uniforms.useDrawRecords, (GLint)true);
+		material.program->Set(material.uniforms.useInstances, (GLint)false);
+		culling.Draw(group);
+	}
+	gDrawCalls = (GLuint)culling.gGroups.size();
+}
+
+
+void RenderQueue::UMakePacket(const Meshes& meshes, const Material* materials, const RenderView& view, GLuint index, DrawPacket& packet) const
+{
+	const RenderObject& object = gObjects[index];
+	// Distance to the nearest point of the object
+	GLfloat distance = std::max(glm::length(object.worldSphere.center - view.cameraPosition) - object.worldSphere.radius, 0.0f);
+
+	// World units covered by one pixel at that point
+	GLfloat unitsPerPixel = view.unitsPerPixel;
+	if (view.perspective)
+		unitsPerPixel *= std::max(distance, 0.1f);
+
+	const Meshes::GLMeshLod& lod = meshes.SelectLod(*object.mesh, object.worldScale, view.pixelError * unitsPerPixel);
+	const Material& material = materials[object.material];
+
+	// Non-negative floats order the same as their bit patterns
+	GLuint depth;
+	std::memcpy(&depth, &distance, sizeof(depth));
+	if (material.pass == RENDER_PASS_TRANSPARENT)
+		depth = ~depth;
+
+	packet.object = index;
+	packet.sortKey = (GLuint64)material.pass << SORT_KEY_PASS_SHIFT
+		| (GLuint64)(material.program->gProgram & 0xFF) << SORT_KEY_PROGRAM_SHIFT
+		| (GLuint64)(object.material & 0xFFF) << SORT_KEY_MATERIAL_SHIFT
+		| (GLuint64)(meshes.gVao & 0xFF) << SORT_KEY_VAO_SHIFT
+		| depth;
+	packet.vao = meshes.gVao;
+	packet.mesh = object.mesh;
+	packet.firstIndex = object.mesh->firstIndex + lod.firstIndex;
+	packet.nIndices = lod.nIndices;
+	packet.material = object.material;
+	packet.model = &object.model;
+	packet.normalMatrix = &object.normalMatrix;
+	packet.uvScale = object.uvScale;
+}
+
+
+void RenderQueue::URecordRange(const Meshes& meshes, const Material* materials, const RenderView& view, GLuint first, GLuint end, CommandBuffer& buffer)
+{
+	buffer.sortKeys.clear();
+	buffer.vaos.clear();
+	buffer.commands.clear();
+	buffer.records.clear();
+	buffer.culled = (end - first) - UCullBounds(view.frustum, gBounds, first, end, gVisible.data());
+	buffer.occluded = 0;
+
+	for (GLuint i = first; i < end; ++i)
+	{
+		if (!gVisible[i])
+			continue;
+
+		const RenderObject& object = gObjects[i];
+		// Same test as BuildPackets; the occlusion buffer is only read
+		if (view.occlusion && !object.occluder && !view.occlusion->IsVisible(object.worldBox))
+		{
+			++buffer.occluded;
+			continue;
+		}
+
+		DrawPacket packet;
+		UMakePacket(meshes, materials, view, i, packet);
+
+		// baseInstance is the draw's place in the merged stream, filled in once it is known
+		DrawElementsIndirectCommand command;
+		command.count = packet.nIndices;
+		command.instanceCount = 1;
+		command.firstIndex = packet.firstIndex;
+		command.baseVertex = packet.mesh->baseVertex;
+		command.baseInstance = 0;
+
+		buffer.sortKeys.push_back(packet.sortKey);
+		buffer.vaos.push_back(packet.vao);
+		buffer.commands.push_back(command);
+		buffer.records.push_back(UDrawRecord(object.model, object.normalMatrix, *object.mesh, object.uvScale, object.material));
+	}
+}
+
+
+void RenderQueue::USubmitCommands(const Material* materials, GLState& state, const DrawElementsIndirectCommand* commands, const DrawRecord* records,
+	const GLuint* vaos, GLuint nDraws)
+{
+	gDrawCalls = 0;
+	if (nDraws == 0)
+		return;
+
+	UReserveDrawIndices(nDraws);
+
+	// Respecifying the whole store each frame lets the driver hand out fresh memory instead of waiting on the GPU
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, gIndirectBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * nDraws, commands, GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, gRecordBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(DrawRecord) * nDraws, records, GL_STREAM_DRAW);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_RECORD_BINDING, gRecordBuffer);
+
+	// One call per run of draws the sort placed next to each other with the same state. Packets carry the meshes' VAO,
+	// the queue's copy of it reads the same buffers plus the draw index
+	GLuint first = 0;
+	while (first < nDraws)
+	{
+		const Material& material = materials[records[first].material];
+		state.UseProgram(material.program->gProgram);
+		state.BindVertexArray(gIndirectVao);
+		material.program->Set(material.uniforms.useDrawRecords, (GLint)true);
+		material.program->Set(material.uniforms.useInstances, (GLint)false);
+
+		GLuint last = first + 1;
+		while (last < nDraws && vaos[last] == vaos[first] && materials[records[last].material].program->gProgram == material.program->gProgram)
+			++last;
+
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(sizeof(DrawElementsIndirectCommand) * first), last - first, 0);
+		++gDrawCalls;
+		first = last;
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+
+void RenderQueue::UReserveDrawIndices(GLuint nDraws)
+{
+	if (nDraws <= gDrawIndexCapacity)
+		return;
+
+	// The draw index buffer only grows, it holds 0, 1, 2, ... so baseInstance selects the draw record
+	gDrawIndexCapacity = std::max(nDraws, gDrawIndexCapacity * 2);
+	std::vector<GLuint> drawIndices(gDrawIndexCapacity);
+	for (GLuint i = 0; i < gDrawIndexCapacity; ++i)
+		drawIndices[i] = i;
+	glBindBuffer(GL_ARRAY_BUFFER, gDrawIndexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLuint) * gDrawIndexCapacity, drawIndices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
+void RenderQueue::UDrawPacket(const Material* materials, const DrawPacket& packet, GLState& state) const
+{
+	const Material& material = materials[packet.material];
+	state.UseProgram(material.program->gProgram);
+	state.BindVertexArray(packet.vao);
+
+	UniformTable& uniforms = *material.program;
+	uniforms.Set(material.uniforms.useDrawRecords, (GLint)false);
+	uniforms.Set(material.uniforms.useInstances, (GLint)false);
+	uniforms.Set(material.uniforms.model, *packet.model);
+	uniforms.Set(material.uniforms.normalMatrix, *packet.normalMatrix);
+	// Dequantize packed positions of the mesh
+	uniforms.Set(material.uniforms.positionOffset, packet.mesh->positionOffset);
+	uniforms.Set(material.uniforms.positionScale, packet.mesh->positionScale);
+	// Tile and select the texture
+	uniforms.Set(material.uniforms.uvScale, packet.uvScale);
+	uniforms.Set(material.uniforms.material, (GLint)packet.material);
+
+	glDrawElementsBaseVertex(GL_TRIANGLES, packet.nIndices, GL_UNSIGNED_INT, (void*)(sizeof(GLuint) * packet.firstIndex), packet.mesh->baseVertex);
+}
+
+
+GLuint RenderQueue::UCountStateChanges(const Material* materials, const std::vector<GLuint>& order) const
+{
+	// Mirrors the binds Submit would issue for this order
+	GLuint changes = 0;
+	const DrawPacket* previous = nullptr;
+	for (GLuint index : order)
+	{
+		const DrawPacket& packet = gPackets[index];
+		const Material& material = materials[packet.material];
+		bool programChanged = !previous || material.program->gProgram != materials[previous->material].program->gProgram;
+
+		changes += programChanged;
+		changes += !previous || packet.vao != previous->vao;
+		changes += !previous || packet.material != previous->material;
+		changes += !previous || packet.mesh != previous->mesh;
+		previous = &packet;
+	}
+	return changes;
+}
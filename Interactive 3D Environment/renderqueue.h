@@ -0,0 +1,314 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "bounds.h"
+#include "frustum.h"
+#include "gpuculling.h"
+#include "occlusion.h"
+#include "occlusionqueries.h"
+#include "meshes.h"
+#include "glstate.h"
+#include "uniforms.h"
+#include "workerpool.h"
+
+// Passes run in this order; opaque draws front to back, transparent ones back to front
+enum RenderPass
+{
+	RENDER_PASS_OPAQUE,
+	RENDER_PASS_TRANSPARENT
+};
+
+// Handles of the uniforms the submission loop writes per draw
+struct DrawUniforms
+{
+	GLint model;
+	GLint normalMatrix;
+	GLint positionOffset;
+	GLint positionScale;
+	GLint uvScale;
+	GLint material;         // Material index of the draw
+	GLint useDrawRecords;   // True while draws read their data from the draw record buffer
+	GLint useInstances;     // True while draws read their data from the instance attributes
+};
+
+// Surface properties shared by every object drawn with them
+struct Material
+{
+	RenderPass pass;
+	UniformTable* program;  // Program the material is drawn with
+	DrawUniforms uniforms;  // Handles into the program's table, see UFindDrawUniforms
+	GLuint textureId;       // Source texture, shaders reach it through MaterialTextures by material index
+};
+
+// Looks up the per-draw uniform handles of a program
+DrawUniforms UFindDrawUniforms(const UniformTable& program);
+
+// One object of the scene description, as authored
+struct SceneObject
+{
+	const Meshes::GLMesh* mesh;
+	GLuint material;        // Index into the material table
+	glm::vec3 scale;
+	GLfloat rotationAngle;  // Radians around rotationAxis
+	glm::vec3 rotationAxis;
+	glm::vec3 translation;
+	glm::vec2 uvScale;      // Texture tiling
+	bool occluder;          // Rasterized into the software occlusion buffer to hide what is behind it
+};
+
+/* Matrix taking normals to world space, the inverse transpose of the model's upper 3x3.
+ * For the object's translation * rotation * scale that is rotation * inverse scale, no general inverse needed.
+ */
+glm::mat3 UNormalMatrix(const SceneObject& object);
+// Same for any invertible model matrix, through the general inverse
+glm::mat3 UNormalMatrix(const glm::mat4& model);
+
+// What packet building needs to know about the view
+struct RenderView
+{
+	glm::vec3 cameraPosition;
+	Frustum frustum;        // Objects entirely outside it get no packet
+	const OcclusionBuffer* occlusion;   // Objects hidden behind its occluders get no packet, null to skip the test
+	bool perspective;
+	GLfloat unitsPerPixel;  // World units per pixel at distance 1 (perspective) or anywhere (orthographic)
+	GLfloat pixelError;     // Largest on-screen deviation allowed, in pixels
+};
+
+/* Draw packets are ordered by a 64 bit key, most significant field first:
+ * pass (4 bits), program (8), material (12), VAO (8), then the float bits of the camera distance (32).
+ * Programs and VAOs are keyed by the low bits of their GL names; a collision only costs state changes.
+ */
+const GLuint SORT_KEY_PASS_SHIFT = 60;
+const GLuint SORT_KEY_PROGRAM_SHIFT = 52;
+const GLuint SORT_KEY_MATERIAL_SHIFT = 40;
+const GLuint SORT_KEY_VAO_SHIFT = 32;
+
+// Everything the submission loop needs for one draw
+struct DrawPacket
+{
+	GLuint64 sortKey;
+	GLuint object;          // Index of the scene object drawn
+	GLuint vao;
+	const Meshes::GLMesh* mesh; // Vertex range and position dequantization
+	GLuint firstIndex;      // First index of the detail level in the shared index buffer
+	GLuint nIndices;
+	GLuint material;
+	const glm::mat4* model;
+	const glm::mat3* normalMatrix;
+	glm::vec2 uvScale;
+};
+
+// Command layout read by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;    // Index of the draw, read back through the draw index attribute
+};
+
+// Shader storage binding of the draw records and vertex attribute carrying the draw index
+const GLuint DRAW_RECORD_BINDING = 0;
+const GLuint DRAW_INDEX_ATTRIBUTE = 3;
+
+/* Per-draw data of indirect submissions, laid out like the std430 DrawRecord array in the vertex shader.
+ * Positions offsets and scales are vec3 in the shader, padded to vec4 here as std430 aligns them to 16 bytes.
+ * The same goes for each column of the normal matrix.
+ */
+struct DrawRecord
+{
+	glm::mat4 model;
+	glm::vec4 normalMatrix[3];
+	glm::vec4 positionOffset;
+	glm::vec4 positionScale;
+	glm::vec2 uvScale;
+	GLuint material;
+	GLuint padding;
+};
+
+static_assert(sizeof(DrawRecord) == 160, "DrawRecord does not match the std430 layout");
+
+/* Draws recorded without touching GL: sort key, VAO, indirect command and packed draw record of each.
+ * Every recording thread fills its own buffer; the GL thread merges and replays them.
+ */
+struct CommandBuffer
+{
+	std::vector<GLuint64> sortKeys;
+	std::vector<GLuint> vaos;
+	std::vector<DrawElementsIndirectCommand> commands;
+	std::vector<DrawRecord> records;    // records[i].material selects the program of draw i
+	GLuint culled;          // Objects of the recorded range outside the frustum
+	GLuint occluded;        // and inside it but hidden by occluders
+};
+
+/* First vertex attribute of the per-instance data of instanced submissions.
+ * The model matrix takes locations 4 to 7, the normal matrix 8 to 10, uv scale 11 and the material 12.
+ */
+const GLuint INSTANCE_ATTRIBUTE = 4;
+
+// Per-instance data of instanced submissions, read through vertex attributes advancing once per instance
+struct InstanceAttributes
+{
+	glm::mat4 model;
+	glm::mat3 normalMatrix;
+	glm::vec2 uvScale;
+	GLuint material;
+};
+
+static_assert(sizeof(InstanceAttributes) == 112, "InstanceAttributes must stay tightly packed");
+
+class RenderQueue
+{
+public:
+	// Scene object with its world transform and bounds worked out once
+	struct RenderObject
+	{
+		const Meshes::GLMesh* mesh;
+		GLuint material;
+		glm::mat4 model;
+		glm::mat3 normalMatrix;
+		glm::vec2 uvScale;
+		BoundingBox worldBox;
+		BoundingSphere worldSphere;
+		GLfloat worldScale;     // Largest axis scale of the model matrix
+		bool occluder;
+	};
+
+	std::vector<RenderObject> gObjects;
+	// World bounds of gObjects, in the layout the SIMD frustum test reads
+	CullBounds gBounds;
+	// Objects the last BuildPackets found outside the frustum, and inside it but hidden by occluders
+	GLuint gCulled;
+	GLuint gOccluded;
+	std::vector<DrawPacket> gPackets;
+	// Submission order, indices into gPackets
+	std::vector<GLuint> gOrder;
+	// GL binds and mesh uniform switches for the frame in scene order and in sorted order
+	GLuint gStateChangesUnsorted;
+	GLuint gStateChangesSorted;
+	// Draw calls issued by the last submission
+	GLuint gDrawCalls;
+	// Packets the last SubmitInstanced drew as instances of another packet's draw
+	GLuint gInstancesMerged;
+	// Draws of the last RecordCommands, merged from every thread and sorted, in the order SubmitRecorded issues them
+	CommandBuffer gRecorded;
+
+public:
+	// Compiles a scene description; objects are drawn in description order
+	void SetScene(const SceneObject* scene, GLuint nObjects);
+
+	// Starts the occlusion buffer's frame and rasterizes the full detail triangles of every occluder into it
+	void RasterizeOccluders(const Meshes& meshes, const glm::mat4& viewProjection, OcclusionBuffer& occlusion) const;
+
+	// Fills gPackets for the frame with the objects in the view frustum, picking each one's detail level and sort key
+	void BuildPackets(const Meshes& meshes, const Material* materials, const RenderView& view);
+
+	// Radix sorts gOrder by sort key and counts the state changes saved
+	void Sort(const Material* materials);
+
+	/* Issues every packet in gOrder, binding programs and VAOs through the state cache.
+	 * Uniforms go through the material's program table, which drops values that did not change.
+	 */
+	void Submit(const Material* materials, GLState& state);
+
+	/* Submits like Submit, culling with hardware occlusion queries on the way: objects visible last frame draw
+	 * first, then the bounding boxes of the others are queried and their draws rendered conditionally.
+	 */
+	void SubmitQueried(const Material* materials, GLState& state, OcclusionQueries& queries, const glm::vec3& cameraPosition);
+
+	// Buffers of the indirect path and the VAO it draws with, a copy of the meshes' VAO with the draw index attribute added
+	void CreateIndirectBuffers(const Meshes& meshes);
+	void DestroyIndirectBuffers();
+
+	// Instance buffer and the VAO that reads it, a copy of the meshes' VAO with the instance attributes added
+	void CreateInstanceBuffers(const Meshes& meshes);
+	void DestroyInstanceBuffers();
+
+	/* Collapses packets of the same material, mesh and detail level into one instanced draw.
+	 * Opaque packets of a material are merged wherever they sit in its run; transparent ones only with the packet
+	 * right before them, so back to front order holds.
+	 */
+	void SubmitInstanced(const Material* materials, GLState& state);
+
+	/* Uploads one command and one draw record per packet in gOrder, then issues a single
+	 * glMultiDrawElementsIndirect for every run of packets sharing program and VAO.
+	 */
+	void SubmitIndirect(const Material* materials, GLState& state);
+
+	/* Uploads the bounds and detail chains of every object for culling on the GPU, plus one draw record per object.
+	 * Objects sharing program and VAO form a draw group. Needs CreateIndirectBuffers first.
+	 */
+	void UploadGpuScene(const Meshes& meshes, const Material* materials, GpuCulling& culling);
+
+	// One command buffer per recording thread, the calling thread included; the other threads are started here
+	void CreateCommandBuffers(GLuint nThreads);
+	void DestroyCommandBuffers();
+
+	/* Does the work of BuildPackets, Sort and the packing of SubmitIndirect on worker threads, without GL calls.
+	 * Each thread records a contiguous range of objects into its own command buffer; the buffers are merged in
+	 * thread order and sorted into gRecorded, so the stream is the same for any number of threads.
+	 */
+	void RecordCommands(const Meshes& meshes, const Material* materials, const RenderView& view);
+
+	// Uploads gRecorded and replays it like SubmitIndirect, on the GL thread
+	void SubmitRecorded(const Material* materials, GLState& state);
+
+	/* Culls and picks detail levels on the GPU, then issues one multi-draw per draw group from the commands the
+	 * culling pass wrote. No packets are built and draws within a group are not sorted.
+	 */
+	void SubmitGpuCulled(const Material* materials, GLState& state, GpuCulling& culling, const RenderView& view);
+
+private:
+	std::vector<GLuint> gScratch;
+	std::vector<unsigned char> gVisible;
+	std::vector<DrawElementsIndirectCommand> gCommands;
+	std::vector<DrawRecord> gRecords;
+	std::vector<GLuint> gVaos;
+	std::vector<CommandBuffer> gCommandBuffers;
+	WorkerPool gRecordingThreads;
+	CommandBuffer gMerged;      // Thread buffers one after the other, before sorting
+	std::vector<GLuint> gMergedOrder;
+
+	GLuint gIndirectBuffer;
+	GLuint gRecordBuffer;
+	GLuint gObjectRecordBuffer; // Draw record of every object, indexed by object for GPU culled draws
+	GLuint gDrawIndexBuffer;
+	GLuint gDrawIndexCapacity;  // Draws the draw index buffer can address
+	GLuint gIndirectVao;
+
+	// Instanced draws of a frame, each a run of instances in gInstances
+	struct InstanceBatch
+	{
+		GLuint packet;          // First packet of the batch, supplies mesh, detail level and material
+		GLuint firstInstance;
+		GLuint nInstances;
+	};
+	std::vector<InstanceBatch> gBatches;
+	std::vector<GLuint> gPacketBatches;     // Batch of each entry of gOrder
+	std::vector<InstanceAttributes> gInstances;
+	GLuint gInstanceBuffer;
+	GLuint gInstancedVao;
+
+	void UReserveDrawIndices(GLuint nDraws);
+	// Detail level and sort key of a visible object, shared by packet building and recording
+	void UMakePacket(const Meshes& meshes, const Material* materials, const RenderView& view, GLuint index, DrawPacket& packet) const;
+	void URecordRange(const Meshes& meshes, const Material* materials, const RenderView& view, GLuint first, GLuint end, CommandBuffer& buffer);
+	// Uploads commands and draw records, then issues one glMultiDrawElementsIndirect per run sharing program and VAO
+	void USubmitCommands(const Material* materials, GLState& state, const DrawElementsIndirectCommand* commands, const DrawRecord* records,
+		const GLuint* vaos, GLuint nDraws);
+	void UDrawPacket(const Material* materials, const DrawPacket& packet, GLState& state) const;
+
+	GLuint UCountStateChanges(const Material* materials, const std::vector<GLuint>& order) const;
+};
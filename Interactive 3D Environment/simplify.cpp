@@ -0,0 +1,444 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "simplify.h"
+#include "primitives.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	// Symmetric 4x4 matrix summing squared distances to a set of planes
+	struct Quadric
+	{
+		double a00, a01, a02, a03;
+		double a11, a12, a13;
+		double a22, a23;
+		double a33;
+	};
+
+	// Candidate edge collapse moving every vertex at one position onto a neighbouring position
+	struct Collapse
+	{
+		GLuint from;
+		GLuint to;
+		double cost;
+	};
+
+	// How far the vertices at a position may move
+	enum PositionKind
+	{
+		POSITION_FREE,      // Inside a smooth manifold patch
+		POSITION_CREASE,    // On a border or seam line, may only slide along it
+		POSITION_LOCKED     // Where border or seam lines meet or end
+	};
+
+	// Edge between two positions together with the vertices it was drawn with
+	struct PositionEdge
+	{
+		unsigned long long key;
+		GLuint a;           // Vertex at the lower position of the key
+		GLuint b;           // Vertex at the higher position of the key
+	};
+
+	void UAddPlane(Quadric& q, const glm::vec3& normal, GLfloat distance)
+	{
+		double x = normal.x;
+		double y = normal.y;
+		double z = normal.z;
+		double d = distance;
+		q.a00 += x * x; q.a01 += x * y; q.a02 += x * z; q.a03 += x * d;
+		q.a11 += y * y; q.a12 += y * z; q.a13 += y * d;
+		q.a22 += z * z; q.a23 += z * d;
+		q.a33 += d * d;
+	}
+
+	void UAddQuadric(Quadric& q, const Quadric& other)
+	{
+		q.a00 += other.a00; q.a01 += other.a01; q.a02 += other.a02; q.a03 += other.a03;
+		q.a11 += other.a11; q.a12 += other.a12; q.a13 += other.a13;
+		q.a22 += other.a22; q.a23 += other.a23;
+		q.a33 += other.a33;
+	}
+
+	// Sum of squared distances from a point to the planes of the quadric
+	double UEvaluate(const Quadric& q, const glm::vec3& p)
+	{
+		double x = p.x;
+		double y = p.y;
+		double z = p.z;
+		double result = q.a00 * x * x + 2.0 * q.a01 * x * y + 2.0 * q.a02 * x * z + 2.0 * q.a03 * x
+			+ q.a11 * y * y + 2.0 * q.a12 * y * z + 2.0 * q.a13 * y
+			+ q.a22 * z * z + 2.0 * q.a23 * z
+			+ q.a33;
+		// Rounding can push a zero error slightly negative
+		return result > 0.0 ? result : 0.0;
+	}
+
+	glm::vec3 UPosition(const GLfloat* verts, GLuint vertex)
+	{
+		const GLfloat* v = verts + vertex * PRIMITIVE_FLOATS_PER_VERTEX;
+		return glm::vec3(v[0], v[1], v[2]);
+	}
+
+	// Maps every vertex to the first vertex sharing its exact position
+	void UWeldPositions(const GLfloat* verts, GLuint nVertices, std::vector<GLuint>& canonical)
+	{
+		std::vector<GLuint> sorted(nVertices);
+		for (GLuint v = 0; v < nVertices; ++v)
+			sorted[v] = v;
+
+		std::sort(sorted.begin(), sorted.end(), [verts](GLuint a, GLuint b)
+			{
+				const GLfloat* pa = verts + a * PRIMITIVE_FLOATS_PER_VERTEX;
+				const GLfloat* pb = verts + b * PRIMITIVE_FLOATS_PER_VERTEX;
+				if (pa[0] != pb[0])
+					return pa[0] < pb[0];
+				if (pa[1] != pb[1])
+					return pa[1] < pb[1];
+				if (pa[2] != pb[2])
+					return pa[2] < pb[2];
+				return a < b;
+			});
+
+		canonical.resize(nVertices);
+		for (GLuint i = 0; i < nVertices; ++i)
+		{
+			GLuint v = sorted[i];
+			GLuint previous = i > 0 ? sorted[i - 1] : v;
+			const GLfloat* p = verts + v * PRIMITIVE_FLOATS_PER_VERTEX;
+			const GLfloat* q = verts + previous * PRIMITIVE_FLOATS_PER_VERTEX;
+			bool same = i > 0 && p[0] == q[0] && p[1] == q[1] && p[2] == q[2];
+			canonical[v] = same ? canonical[previous] : v;
+		}
+	}
+
+	unsigned long long UEdgeKey(GLuint a, GLuint b)
+	{
+		return ((unsigned long long)std::min(a, b) << 32) | std::max(a, b);
+	}
+
+	// Finds the border and seam edges (creases) and classifies every position against them
+	void UClassifyPositions(const std::vector<GLuint>& indices, const std::vector<GLuint>& canonical, GLuint nVertices,
+		std::vector<PositionKind>& kind, std::vector<unsigned long long>& creases)
+	{
+		std::vector<PositionEdge> edges;
+		edges.reserve(indices.size());
+		for (size_t t = 0; t + 2 < indices.size(); t += 3)
+		{
+			for (GLuint corner = 0; corner < 3; ++corner)
+			{
+				GLuint a = indices[t + corner];
+				GLuint b = indices[t + (corner + 1) % 3];
+				if (canonical[a] > canonical[b])
+					std::swap(a, b);
+				PositionEdge edge = { UEdgeKey(canonical[a], canonical[b]), a, b };
+				edges.push_back(edge);
+			}
+		}
+		std::sort(edges.begin(), edges.end(), [](const PositionEdge& x, const PositionEdge& y)
+			{
+				if (x.key != y.key)
+					return x.key < y.key;
+				if (x.a != y.a)
+					return x.a < y.a;
+				return x.b < y.b;
+			});
+
+		// Interior edges are shared by exactly two triangles drawn with the same two vertices
+		std::vector<GLuint> degree(nVertices, 0);
+		creases.clear();
+		for (size_t i = 0; i < edges.size();)
+		{
+			size_t j = i;
+			while (j < edges.size() && edges[j].key == edges[i].key)
+				++j;
+
+			bool crease = j - i != 2 || edges[i].a != edges[i + 1].a || edges[i].b != edges[i + 1].b;
+			if (crease)
+			{
+				creases.push_back(edges[i].key);
+				++degree[canonical[edges[i].a]];
+				++degree[canonical[edges[i].b]];
+			}
+			i = j;
+		}
+
+		// A position drawn through several vertices is on a seam even if its edges do not show it
+		std::vector<GLuint> owner(nVertices, ~0u);
+		std::vector<bool> shared(nVertices, false);
+		for (GLuint vertex : indices)
+		{
+			GLuint& first = owner[canonical[vertex]];
+			if (first == ~0u)
+				first = vertex;
+			else if (first != vertex)
+				shared[canonical[vertex]] = true;
+		}
+
+		kind.assign(nVertices, POSITION_FREE);
+		for (GLuint p = 0; p < nVertices; ++p)
+		{
+			if (degree[p] == 2)
+				kind[p] = POSITION_CREASE;
+			else if (degree[p] > 0 || shared[p])
+				kind[p] = POSITION_LOCKED;
+		}
+	}
+
+	// Finds a vertex at the target position sharing a triangle with the vertex, ~0u if there is none
+	GLuint UFindNeighbour(GLuint vertex, GLuint target, const std::vector<GLuint>& indices, const std::vector<GLuint>& canonical,
+		const std::vector<GLuint>& adjacencyOffset, const std::vector<GLuint>& adjacency)
+	{
+		for (GLuint a = adjacencyOffset[vertex]; a < adjacencyOffset[vertex + 1]; ++a)
+		{
+			const GLuint* triangle = &indices[adjacency[a] * 3];
+			for (GLuint corner = 0; corner < 3; ++corner)
+			{
+				if (canonical[triangle[corner]] == target)
+					return triangle[corner];
+			}
+		}
+		return ~0u;
+	}
+}
+
+
+SimplifyResult USimplifyMesh(const GLuint* indices, GLuint nIndices, const GLfloat* verts, GLuint nVertices,
+	GLuint targetIndices, GLfloat maxError, GLuint* destination)
+{
+	std::vector<GLuint> current(indices, indices + nIndices);
+	SimplifyResult result = { nIndices, 0.0f };
+
+	std::vector<GLuint> canonical;
+	UWeldPositions(verts, nVertices, canonical);
+
+	// Every position starts with the planes of the triangles around it
+	std::vector<Quadric> quadrics(nVertices, Quadric());
+	for (GLuint t = 0; t + 2 < nIndices; t += 3)
+	{
+		glm::vec3 p0 = UPosition(verts, current[t]);
+		glm::vec3 p1 = UPosition(verts, current[t + 1]);
+		glm::vec3 p2 = UPosition(verts, current[t + 2]);
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		GLfloat length = glm::length(normal);
+		if (length == 0.0f)
+			continue;
+
+		normal /= length;
+		GLfloat distance = -glm::dot(normal, p0);
+		for (GLuint corner = 0; corner < 3; ++corner)
+			UAddPlane(quadrics[canonical[current[t + corner]]], normal, distance);
+	}
+
+	// Open edges add a plane standing on the edge, otherwise sliding along a flat border would look free
+	std::vector<unsigned long long> edgeKeys;
+	for (GLuint i = 0; i < nIndices; ++i)
+		edgeKeys.push_back(UEdgeKey(canonical[current[i]], canonical[current[i - i % 3 + (i + 1) % 3]]));
+	std::vector<unsigned long long> sortedKeys(edgeKeys);
+	std::sort(sortedKeys.begin(), sortedKeys.end());
+
+	for (GLuint i = 0; i < nIndices; ++i)
+	{
+		std::pair<std::vector<unsigned long long>::iterator, std::vector<unsigned long long>::iterator> range =
+			std::equal_range(sortedKeys.begin(), sortedKeys.end(), edgeKeys[i]);
+		if (range.second - range.first != 1)
+			continue;
+
+		GLuint t = i - i % 3;
+		glm::vec3 p0 = UPosition(verts, current[i]);
+		glm::vec3 p1 = UPosition(verts, current[t + (i + 1) % 3]);
+		glm::vec3 p2 = UPosition(verts, current[t + (i + 2) % 3]);
+		glm::vec3 normal = glm::cross(glm::cross(p1 - p0, p2 - p0), p1 - p0);
+		GLfloat length = glm::length(normal);
+		if (length == 0.0f)
+			continue;
+
+		normal /= length;
+		GLfloat distance = -glm::dot(normal, p0);
+		UAddPlane(quadrics[canonical[current[i]]], normal, distance);
+		UAddPlane(quadrics[canonical[current[t + (i + 1) % 3]]], normal, distance);
+	}
+
+	const double maxCost = (double)maxError * maxError;
+	std::vector<PositionKind> kind;
+	std::vector<unsigned long long> creases;
+	std::vector<Collapse> collapses;
+	std::vector<GLuint> adjacencyOffset(nVertices + 1);
+	std::vector<GLuint> adjacency;
+	std::vector<GLuint> groupOffset(nVertices + 1);
+	std::vector<GLuint> group;
+	std::vector<GLuint> targets;
+	std::vector<GLuint> remap(nVertices);
+	std::vector<bool> touched(nVertices);
+
+	// Each pass applies a set of independent collapses, cheapest first
+	while (current.size() > targetIndices)
+	{
+		GLuint nTriangles = (GLuint)current.size() / 3;
+		UClassifyPositions(current, canonical, nVertices, kind, creases);
+
+		// Vertex to triangle adjacency in compressed rows
+		std::fill(adjacencyOffset.begin(), adjacencyOffset.end(), 0);
+		for (GLuint vertex : current)
+			++adjacencyOffset[vertex + 1];
+		for (GLuint v = 0; v < nVertices; ++v)
+			adjacencyOffset[v + 1] += adjacencyOffset[v];
+		adjacency.resize(current.size());
+		std::vector<GLuint> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+		for (GLuint i = 0; i < (GLuint)current.size(); ++i)
+			adjacency[fill[current[i]]++] = i / 3;
+
+		// Referenced vertices grouped by position, so seam copies move together
+		std::fill(groupOffset.begin(), groupOffset.end(), 0);
+		for (GLuint v = 0; v < nVertices; ++v)
+		{
+			if (adjacencyOffset[v + 1] > adjacencyOffset[v])
+				++groupOffset[canonical[v] + 1];
+		}
+		for (GLuint v = 0; v < nVertices; ++v)
+			groupOffset[v + 1] += groupOffset[v];
+		group.resize(groupOffset[nVertices]);
+		fill.assign(groupOffset.begin(), groupOffset.end() - 1);
+		for (GLuint v = 0; v < nVertices; ++v)
+		{
+			if (adjacencyOffset[v + 1] > adjacencyOffset[v])
+				group[fill[canonical[v]]++] = v;
+		}
+
+		collapses.clear();
+		for (GLuint i = 0; i < (GLuint)current.size(); ++i)
+		{
+			GLuint from = canonical[current[i]];
+			GLuint to = canonical[current[i - i % 3 + (i + 1) % 3]];
+			if (from == to || kind[from] == POSITION_LOCKED)
+				continue;
+			// Crease positions slide along their crease so borders and seams keep their shape
+			if (kind[from] == POSITION_CREASE && !std::binary_search(creases.begin(), creases.end(), UEdgeKey(from, to)))
+				continue;
+
+			Quadric q = quadrics[from];
+			UAddQuadric(q, quadrics[to]);
+			Collapse collapse = { from, to, UEvaluate(q, UPosition(verts, to)) };
+			if (collapse.cost <= maxCost)
+				collapses.push_back(collapse);
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+			{
+				return a.cost < b.cost;
+			});
+
+		for (GLuint v = 0; v < nVertices; ++v)
+			remap[v] = v;
+		std::fill(touched.begin(), touched.end(), false);
+
+		GLuint remainingTriangles = nTriangles;
+		GLuint applied = 0;
+		for (const Collapse& collapse : collapses)
+		{
+			if (remainingTriangles * 3 <= targetIndices)
+				break;
+			if (touched[collapse.from] || touched[collapse.to])
+				continue;
+
+			// Every vertex at the position needs a neighbour at the target to merge with
+			targets.clear();
+			for (GLuint g = groupOffset[collapse.from]; g < groupOffset[collapse.from + 1]; ++g)
+			{
+				GLuint target = UFindNeighbour(group[g], collapse.to, current, canonical, adjacencyOffset, adjacency);
+				if (target == ~0u)
+					break;
+				targets.push_back(target);
+			}
+			if (targets.size() != groupOffset[collapse.from + 1] - groupOffset[collapse.from])
+				continue;
+
+			// Reject collapses that would fold a surviving triangle over
+			glm::vec3 target = UPosition(verts, collapse.to);
+			GLuint removed = 0;
+			bool flips = false;
+			for (GLuint g = groupOffset[collapse.from]; g < groupOffset[collapse.from + 1] && !flips; ++g)
+			{
+				GLuint vertex = group[g];
+				for (GLuint a = adjacencyOffset[vertex]; a < adjacencyOffset[vertex + 1] && !flips; ++a)
+				{
+					const GLuint* triangle = &current[adjacency[a] * 3];
+					glm::vec3 before[3];
+					glm::vec3 after[3];
+					bool collapsesAway = false;
+					for (GLuint corner = 0; corner < 3; ++corner)
+					{
+						before[corner] = UPosition(verts, triangle[corner]);
+						after[corner] = triangle[corner] == vertex ? target : before[corner];
+						collapsesAway = collapsesAway || canonical[triangle[corner]] == collapse.to;
+					}
+
+					if (collapsesAway)
+					{
+						++removed;
+						continue;
+					}
+
+					glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+					glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+					flips = glm::dot(normalBefore, normalAfter) <= 0.0f;
+				}
+			}
+			if (flips)
+				continue;
+
+			// Neighbours keep their triangles fixed for the rest of the pass so the flip test stays valid
+			for (GLuint position : { collapse.from, collapse.to })
+			{
+				for (GLuint g = groupOffset[position]; g < groupOffset[position + 1]; ++g)
+				{
+					for (GLuint a = adjacencyOffset[group[g]]; a < adjacencyOffset[group[g] + 1]; ++a)
+					{
+						const GLuint* triangle = &current[adjacency[a] * 3];
+						touched[canonical[triangle[0]]] = true;
+						touched[canonical[triangle[1]]] = true;
+						touched[canonical[triangle[2]]] = true;
+					}
+				}
+			}
+
+			for (GLuint g = groupOffset[collapse.from]; g < groupOffset[collapse.from + 1]; ++g)
+				remap[group[g]] = targets[g - groupOffset[collapse.from]];
+			UAddQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+			result.error = std::max(result.error, (GLfloat)std::sqrt(collapse.cost));
+			remainingTriangles -= std::min(removed, remainingTriangles);
+			++applied;
+		}
+
+		if (applied == 0)
+			break;
+
+		// Rewrite the triangles, dropping the ones that collapsed to a line
+		GLuint out = 0;
+		for (GLuint t = 0; t < nTriangles; ++t)
+		{
+			GLuint a = remap[current[t * 3]];
+			GLuint b = remap[current[t * 3 + 1]];
+			GLuint c = remap[current[t * 3 + 2]];
+			if (canonical[a] == canonical[b] || canonical[b] == canonical[c] || canonical[a] == canonical[c])
+				continue;
+
+			current[out++] = a;
+			current[out++] = b;
+			current[out++] = c;
+		}
+		current.resize(out);
+	}
+
+	std::copy(current.begin(), current.end(), destination);
+	result.nIndices = (GLuint)current.size();
+	return result;
+}
@@ -0,0 +1,27 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+// Outcome of one simplification run
+struct SimplifyResult
+{
+	GLuint nIndices;    // Number of indices written to the destination
+	GLfloat error;      // Largest quadric error of an applied collapse, as a distance in mesh units
+};
+
+/* Quadric error metric simplification of an indexed triangle list over interleaved vertices.
+ * Vertices are collapsed onto neighbouring vertices, so the result indexes the same vertex buffer and
+ * can be stored as another detail level of the mesh.
+ * Vertices on open borders and on texture / normal seams (one position, several vertices) are never moved,
+ * which keeps silhouettes of open meshes and seams closed.
+ * Stops once the result has targetIndices indices or less, or no collapse stays under maxError.
+ * destination needs room for nIndices indices.
+ */
+SimplifyResult USimplifyMesh(const GLuint* indices, GLuint nIndices, const GLfloat* verts, GLuint nVertices,
+	GLuint targetIndices, GLfloat maxError, GLuint* destination);
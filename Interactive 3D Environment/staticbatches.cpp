@@ -0,0 +1,137 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "staticbatches.h"
+#include "primitives.h"
+#include "vertexformat.h"
+
+#include <iostream>
+
+void StaticBatches::CreateStaticBatches(const Meshes& meshes, const std::vector<RenderQueue::RenderObject>& objects)
+{
+	// Materials in order of first appearance, each with the objects drawn with it
+	std::vector<GLuint> materials;
+	std::vector<std::vector<GLuint>> batchObjects;
+	for (GLuint i = 0; i < objects.size(); ++i)
+	{
+		GLuint batch = 0;
+		while (batch < materials.size() && materials[batch] != objects[i].material)
+			++batch;
+		if (batch == materials.size())
+		{
+			materials.push_back(objects[i].material);
+			batchObjects.emplace_back();
+		}
+		batchObjects[batch].push_back(i);
+	}
+
+	std::vector<GLfloat> verts;
+	std::vector<GLuint> indices;
+	std::vector<PackedVertex> packed;
+	gBatches.resize(materials.size());
+	gBounds.Resize((GLuint)materials.size());
+	for (GLuint b = 0; b < materials.size(); ++b)
+	{
+		Batch& batch = gBatches[b];
+		batch.material = materials[b];
+		batch.nObjects = (GLuint)batchObjects[b].size();
+		batch.baseVertex = (GLint)(verts.size() / PRIMITIVE_FLOATS_PER_VERTEX);
+		batch.firstIndex = (GLuint)indices.size();
+
+		// The full detail level of every object, in world space, indices relative to the batch's first vertex
+		GLuint nVertices = 0;
+		for (GLuint o : batchObjects[b])
+		{
+			const RenderQueue::RenderObject& object = objects[o];
+			const Meshes::GLMesh& mesh = *object.mesh;
+			for (GLuint v = mesh.baseVertex; v < mesh.baseVertex + mesh.nVertices; ++v)
+			{
+				glm::vec3 position = glm::vec3(object.model * glm::vec4(meshes.gPositions[v], 1.0f));
+				glm::vec3 normal = glm::normalize(object.normalMatrix * meshes.gNormals[v]);
+				glm::vec2 texCoord = meshes.gTexCoords[v] * object.uvScale;
+				verts.insert(verts.end(), { position.x, position.y, position.z, normal.x, normal.y, normal.z, texCoord.x, texCoord.y });
+			}
+
+			const Meshes::GLMeshLod& lod = mesh.lods[0];
+			for (GLuint k = 0; k < lod.nIndices; ++k)
+				indices.push_back(meshes.gIndices[mesh.firstIndex + lod.firstIndex + k] + nVertices);
+			nVertices += mesh.nVertices;
+		}
+		batch.nIndices = (GLuint)indices.size() - batch.firstIndex;
+
+		const GLfloat* batchVerts = &verts[batch.baseVertex * PRIMITIVE_FLOATS_PER_VERTEX];
+		UComputeBounds(batchVerts, nVertices, batch.worldBox, batch.worldSphere);
+		gBounds.Set(b, batch.worldBox, batch.worldSphere);
+
+		// Packed positions are quantized over the batch's own bounds, like those of a mesh
+		batch.positionOffset = glm::vec3(0.0f);
+		batch.positionScale = glm::vec3(1.0f);
+		if (meshes.gVertexFormat == VERTEX_FORMAT_PACKED)
+		{
+			packed.resize(batch.baseVertex + nVertices);
+			PackingError error;
+			UPackVertices(batchVerts, nVertices, &packed[batch.baseVertex], batch.positionOffset, batch.positionScale, error);
+		}
+	}
+
+	glGenVertexArrays(1, &gVao);
+	glBindVertexArray(gVao);
+	glGenBuffers(2, gVbos);
+	glBindBuffer(GL_ARRAY_BUFFER, gVbos[0]);
+	if (meshes.gVertexFormat == VERTEX_FORMAT_PACKED)
+		glBufferData(GL_ARRAY_BUFFER, sizeof(PackedVertex) * packed.size(), packed.data(), GL_STATIC_DRAW);
+	else
+		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * verts.size(), verts.data(), GL_STATIC_DRAW);
+	UBindVertexAttributes(meshes.gVertexFormat);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gVbos[1]);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indices.size(), indices.data(), GL_STATIC_DRAW);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	gCulled = 0;
+	gDrawCalls = 0;
+	std::cout << "INFO: Static batching merged " << objects.size() << " objects into " << gBatches.size() << " batches ("
+		<< verts.size() / PRIMITIVE_FLOATS_PER_VERTEX << " vertices, " << indices.size() / 3 << " triangles)" << std::endl;
+}
+
+
+void StaticBatches::DestroyStaticBatches()
+{
+	glDeleteVertexArrays(1, &gVao);
+	glDeleteBuffers(2, gVbos);
+}
+
+
+void StaticBatches::Submit(const Material* materials, GLState& state, const Frustum& frustum)
+{
+	gCulled = (GLuint)gBatches.size() - UCullBounds(frustum, gBounds, gVisible);
+	gDrawCalls = 0;
+
+	for (GLuint b = 0; b < gBatches.size(); ++b)
+	{
+		if (!gVisible[b])
+			continue;
+
+		const Batch& batch = gBatches[b];
+		const Material& material = materials[batch.material];
+		state.UseProgram(material.program->gProgram);
+		state.BindVertexArray(gVao);
+
+		// Transforms and tiling are baked into the vertices
+		UniformTable& uniforms = *material.program;
+		uniforms.Set(material.uniforms.useDrawRecords, (GLint)false);
+		uniforms.Set(material.uniforms.useInstances, (GLint)false);
+		uniforms.Set(material.uniforms.model, glm::mat4(1.0f));
+		uniforms.Set(material.uniforms.normalMatrix, glm::mat3(1.0f));
+		uniforms.Set(material.uniforms.positionOffset, batch.positionOffset);
+		uniforms.Set(material.uniforms.positionScale, batch.positionScale);
+		uniforms.Set(material.uniforms.uvScale, glm::vec2(1.0f));
+		uniforms.Set(material.uniforms.material, (GLint)batch.material);
+
+		glDrawElementsBaseVertex(GL_TRIANGLES, batch.nIndices, GL_UNSIGNED_INT, (void*)(sizeof(GLuint) * batch.firstIndex), batch.baseVertex);
+		++gDrawCalls;
+	}
+}
@@ -0,0 +1,63 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "bounds.h"
+#include "frustum.h"
+#include "glstate.h"
+#include "meshes.h"
+#include "renderqueue.h"
+
+/* Immobile objects baked into world space and merged into one vertex and index range per material.
+ * Each batch draws in a single call with identity transforms: the model matrix is applied to the positions,
+ * the normal matrix to the normals and the uvScale tiling to the texture coords. Batches keep the bounds of
+ * everything merged into them, so whole batches can still be frustum culled.
+ * Objects are merged at full detail; a batch has no detail levels of its own.
+ */
+class StaticBatches
+{
+public:
+	struct Batch
+	{
+		GLuint material;
+		GLuint nObjects;
+		GLuint firstIndex;      // First index of the batch in the batch index buffer, relative to baseVertex
+		GLuint nIndices;
+		GLint baseVertex;
+		glm::vec3 positionOffset;   // Dequantization of packed positions over the batch bounds (0 for float vertices)
+		glm::vec3 positionScale;    // (1 for float vertices)
+		BoundingBox worldBox;
+		BoundingSphere worldSphere;
+	};
+
+	std::vector<Batch> gBatches;
+	// World bounds of gBatches, in the layout the SIMD frustum test reads
+	CullBounds gBounds;
+	// Batch geometry, stored in the vertex format of the meshes
+	GLuint gVao;
+	GLuint gVbos[2];
+	// Batches the last Submit found outside the frustum, and draw calls it issued
+	GLuint gCulled;
+	GLuint gDrawCalls;
+
+public:
+	// Bakes the objects, grouped by material in order of first appearance and kept in order within a batch
+	void CreateStaticBatches(const Meshes& meshes, const std::vector<RenderQueue::RenderObject>& objects);
+	void DestroyStaticBatches();
+
+	// Draws every batch in the frustum, binding programs and the batch VAO through the state cache
+	void Submit(const Material* materials, GLState& state, const Frustum& frustum);
+
+private:
+	std::vector<unsigned char> gVisible;
+};
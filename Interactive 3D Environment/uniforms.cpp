@@ -0,0 +1,181 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "uniforms.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	// Size of one value of a uniform type as the Set functions store it
+	GLuint UTypeBytes(GLenum type)
+	{
+		switch (type)
+		{
+		case GL_FLOAT_VEC2:
+			return sizeof(glm::vec2);
+		case GL_FLOAT_VEC3:
+			return sizeof(glm::vec3);
+		case GL_FLOAT_VEC4:
+			return sizeof(glm::vec4);
+		case GL_FLOAT_MAT3:
+			return sizeof(glm::mat3);
+		case GL_FLOAT_MAT4:
+			return sizeof(glm::mat4);
+		default:
+			// Scalars, booleans and samplers
+			return sizeof(GLint);
+		}
+	}
+
+	// Types set through the GLint overload
+	bool UIntegerType(GLenum type)
+	{
+		switch (type)
+		{
+		case GL_INT:
+		case GL_BOOL:
+		case GL_SAMPLER_2D:
+		case GL_SAMPLER_2D_ARRAY:
+		case GL_SAMPLER_CUBE:
+			return true;
+		default:
+			return false;
+		}
+	}
+}
+
+
+bool UniformTable::Reflect(GLuint program)
+{
+	gProgram = program;
+	gUniforms.clear();
+	gValues.clear();
+
+	GLint nUniforms = 0;
+	GLint maxLength = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &nUniforms);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+	std::vector<GLchar> name(maxLength + 1);
+	for (GLint i = 0; i < nUniforms; ++i)
+	{
+		Uniform uniform;
+		GLsizei length = 0;
+		glGetActiveUniform(program, (GLuint)i, (GLsizei)name.size(), &length, &uniform.count, &uniform.type, name.data());
+		uniform.name.assign(name.data(), length);
+
+		// Members of uniform blocks have no location and are not set one by one
+		uniform.location = glGetUniformLocation(program, uniform.name.c_str());
+		if (uniform.location < 0)
+			continue;
+
+		if (uniform.name.size() > 3 && uniform.name.compare(uniform.name.size() - 3, 3, "[0]") == 0)
+			uniform.name.resize(uniform.name.size() - 3);
+
+		uniform.valueOffset = (GLuint)gValues.size();
+		uniform.valueKnown = false;
+		gValues.resize(gValues.size() + UTypeBytes(uniform.type));
+		gUniforms.push_back(uniform);
+	}
+
+	if (gUniforms.empty() && nUniforms > 0)
+	{
+		std::cout << "ERROR: No settable uniforms found in program " << program << std::endl;
+		return false;
+	}
+
+	std::cout << "INFO: Program " << program << " has " << gUniforms.size() << " active uniforms" << std::endl;
+	return true;
+}
+
+
+GLint UniformTable::Find(const char* name) const
+{
+	for (GLuint i = 0; i < gUniforms.size(); ++i)
+	{
+		if (gUniforms[i].name == name)
+			return (GLint)i;
+	}
+	return -1;
+}
+
+
+void UniformTable::Set(GLint handle, GLint value)
+{
+	if (UChanged(handle, GL_INT, &value, sizeof(value)))
+		glProgramUniform1i(gProgram, gUniforms[handle].location, value);
+}
+
+
+void UniformTable::Set(GLint handle, GLfloat value)
+{
+	if (UChanged(handle, GL_FLOAT, &value, sizeof(value)))
+		glProgramUniform1f(gProgram, gUniforms[handle].location, value);
+}
+
+
+void UniformTable::Set(GLint handle, const glm::vec2& value)
+{
+	if (UChanged(handle, GL_FLOAT_VEC2, &value, sizeof(value)))
+		glProgramUniform2fv(gProgram, gUniforms[handle].location, 1, glm::value_ptr(value));
+}
+
+
+void UniformTable::Set(GLint handle, const glm::vec3& value)
+{
+	if (UChanged(handle, GL_FLOAT_VEC3, &value, sizeof(value)))
+		glProgramUniform3fv(gProgram, gUniforms[handle].location, 1, glm::value_ptr(value));
+}
+
+
+void UniformTable::Set(GLint handle, const glm::vec4& value)
+{
+	if (UChanged(handle, GL_FLOAT_VEC4, &value, sizeof(value)))
+		glProgramUniform4fv(gProgram, gUniforms[handle].location, 1, glm::value_ptr(value));
+}
+
+
+void UniformTable::Set(GLint handle, const glm::mat3& value)
+{
+	if (UChanged(handle, GL_FLOAT_MAT3, &value, sizeof(value)))
+		glProgramUniformMatrix3fv(gProgram, gUniforms[handle].location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+
+void UniformTable::Set(GLint handle, const glm::mat4& value)
+{
+	if (UChanged(handle, GL_FLOAT_MAT4, &value, sizeof(value)))
+		glProgramUniformMatrix4fv(gProgram, gUniforms[handle].location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+
+bool UniformTable::UChanged(GLint handle, GLenum type, const void* value, GLuint bytes)
+{
+	if (handle < 0)
+		return false;
+
+	Uniform& uniform = gUniforms[handle];
+	bool typeMatches = uniform.type == type || (type == GL_INT && UIntegerType(uniform.type));
+	if (!typeMatches)
+	{
+#ifdef _DEBUG
+		std::cout << "WARNING: Uniform " << uniform.name << " set with the wrong type" << std::endl;
+#endif
+		return false;
+	}
+
+	unsigned char* last = &gValues[uniform.valueOffset];
+	if (uniform.valueKnown && std::memcmp(last, value, bytes) == 0)
+		return false;
+
+	std::memcpy(last, value, bytes);
+	uniform.valueKnown = true;
+	return true;
+}
@@ -0,0 +1,56 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// Active uniforms of a linked program, set through handles instead of names
+class UniformTable
+{
+public:
+	// One active uniform as reported by glGetActiveUniform
+	struct Uniform
+	{
+		std::string name;   // Array uniforms drop the trailing "[0]"
+		GLenum type;        // GL_FLOAT_VEC3, GL_FLOAT_MAT4, GL_SAMPLER_2D, ...
+		GLint count;        // Array length, 1 for plain uniforms
+		GLint location;
+		GLuint valueOffset; // Offset of the last value sent in gValues
+		bool valueKnown;    // False until the first value is sent
+	};
+
+	GLuint gProgram;
+	std::vector<Uniform> gUniforms;
+
+public:
+	// Enumerates the active uniforms of a linked program; the handle of a uniform is its index in gUniforms
+	bool Reflect(GLuint program);
+
+	// Handle of the named uniform, -1 if the program does not use it
+	GLint Find(const char* name) const;
+
+	/* Send a value unless it equals the last one sent through this table.
+	 * Values go through glProgramUniform, so the program need not be bound; handle -1 is ignored like location -1.
+	 */
+	void Set(GLint handle, GLint value);
+	void Set(GLint handle, GLfloat value);
+	void Set(GLint handle, const glm::vec2& value);
+	void Set(GLint handle, const glm::vec3& value);
+	void Set(GLint handle, const glm::vec4& value);
+	void Set(GLint handle, const glm::mat3& value);
+	void Set(GLint handle, const glm::mat4& value);
+
+private:
+	std::vector<unsigned char> gValues;
+
+	bool UChanged(GLint handle, GLenum type, const void* value, GLuint bytes);
+};
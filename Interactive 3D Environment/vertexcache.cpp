@@ -0,0 +1,259 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "vertexcache.h"
+#include "primitives.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+	// Triangle range produced by Tipsify between two dead ends
+	struct TriangleCluster
+	{
+		GLuint firstTriangle;
+		GLuint nTriangles;
+		GLfloat sortKey;
+	};
+
+	// Returns a vertex that still has live triangles from the dead-end stack, or scans forward for one
+	int USkipDeadEnd(std::vector<GLuint>& deadEnds, const std::vector<GLuint>& liveTriangles, GLuint& cursor, GLuint nVertices)
+	{
+		while (!deadEnds.empty())
+		{
+			GLuint vertex = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveTriangles[vertex] > 0)
+				return vertex;
+		}
+
+		while (cursor < nVertices)
+		{
+			if (liveTriangles[cursor] > 0)
+				return cursor;
+			++cursor;
+		}
+
+		return -1;
+	}
+
+	// Area weighted centroid and normal of a run of triangles
+	void UTriangleMoments(const GLuint* indices, GLuint firstTriangle, GLuint nTriangles, const GLfloat* verts, glm::vec3& centroid, glm::vec3& normal)
+	{
+		centroid = glm::vec3(0.0f);
+		normal = glm::vec3(0.0f);
+		GLfloat totalArea = 0.0f;
+
+		for (GLuint t = firstTriangle; t < firstTriangle + nTriangles; ++t)
+		{
+			const GLfloat* a = verts + indices[t * 3] * PRIMITIVE_FLOATS_PER_VERTEX;
+			const GLfloat* b = verts + indices[t * 3 + 1] * PRIMITIVE_FLOATS_PER_VERTEX;
+			const GLfloat* c = verts + indices[t * 3 + 2] * PRIMITIVE_FLOATS_PER_VERTEX;
+			glm::vec3 p0(a[0], a[1], a[2]);
+			glm::vec3 p1(b[0], b[1], b[2]);
+			glm::vec3 p2(c[0], c[1], c[2]);
+
+			glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0); // length is twice the area
+			GLfloat area = glm::length(faceNormal) * 0.5f;
+			centroid += (p0 + p1 + p2) * (area / 3.0f);
+			normal += faceNormal;
+			totalArea += area;
+		}
+
+		if (totalArea > 0.0f)
+			centroid /= totalArea;
+	}
+}
+
+
+VertexCacheStats UAnalyzeVertexCache(const GLuint* indices, GLuint nIndices, GLuint nVertices, GLuint cacheSize)
+{
+	// Time stamp of the last time each vertex entered the FIFO
+	std::vector<GLuint> entered(nVertices, 0);
+	std::vector<bool> used(nVertices, false);
+	GLuint time = cacheSize + 1;
+	GLuint misses = 0;
+	GLuint usedVertices = 0;
+
+	for (GLuint i = 0; i < nIndices; ++i)
+	{
+		GLuint vertex = indices[i];
+		if (time - entered[vertex] > cacheSize)
+		{
+			entered[vertex] = time++;
+			++misses;
+		}
+		if (!used[vertex])
+		{
+			used[vertex] = true;
+			++usedVertices;
+		}
+	}
+
+	VertexCacheStats stats;
+	stats.acmr = nIndices ? (GLfloat)misses / (nIndices / 3) : 0.0f;
+	stats.atvr = usedVertices ? (GLfloat)misses / usedVertices : 0.0f;
+	return stats;
+}
+
+
+void UOptimizeTriangleOrder(GLuint* indices, GLuint nIndices, const GLfloat* verts, GLuint nVertices, GLuint cacheSize)
+{
+	const GLuint nTriangles = nIndices / 3;
+	if (nTriangles == 0)
+		return;
+
+	// Vertex to triangle adjacency in compressed rows
+	std::vector<GLuint> liveTriangles(nVertices, 0);
+	for (GLuint i = 0; i < nIndices; ++i)
+		++liveTriangles[indices[i]];
+
+	std::vector<GLuint> adjacencyOffset(nVertices + 1, 0);
+	for (GLuint v = 0; v < nVertices; ++v)
+		adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+
+	std::vector<GLuint> adjacency(nIndices);
+	std::vector<GLuint> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+	for (GLuint i = 0; i < nIndices; ++i)
+		adjacency[fill[indices[i]]++] = i / 3;
+
+	// Tipsify: fan around the current vertex, then move to the neighbour most likely still in the cache
+	std::vector<GLuint> entered(nVertices, 0);
+	std::vector<bool> emitted(nTriangles, false);
+	std::vector<GLuint> deadEnds;
+	std::vector<GLuint> candidates;
+	std::vector<GLuint> order;
+	std::vector<TriangleCluster> clusters;
+	order.reserve(nTriangles);
+
+	GLuint time = cacheSize + 1;
+	GLuint cursor = 0;
+	int fanVertex = indices[0];
+	TriangleCluster cluster = { 0, 0, 0.0f };
+
+	while (fanVertex >= 0)
+	{
+		candidates.clear();
+
+		for (GLuint a = adjacencyOffset[fanVertex]; a < adjacencyOffset[fanVertex + 1]; ++a)
+		{
+			GLuint triangle = adjacency[a];
+			if (emitted[triangle])
+				continue;
+
+			for (GLuint corner = 0; corner < 3; ++corner)
+			{
+				GLuint vertex = indices[triangle * 3 + corner];
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				--liveTriangles[vertex];
+				if (time - entered[vertex] > cacheSize)
+					entered[vertex] = time++;
+			}
+
+			emitted[triangle] = true;
+			order.push_back(triangle);
+		}
+
+		// Pick the candidate that will still be cached after its remaining triangles are emitted
+		int next = -1;
+		GLuint bestPriority = 0;
+		for (GLuint vertex : candidates)
+		{
+			if (liveTriangles[vertex] == 0)
+				continue;
+
+			GLuint priority = 0;
+			if (time - entered[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+				priority = time - entered[vertex];
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				next = vertex;
+			}
+		}
+
+		// A dead end closes the current cluster
+		if (next < 0)
+		{
+			next = USkipDeadEnd(deadEnds, liveTriangles, cursor, nVertices);
+			cluster.nTriangles = (GLuint)order.size() - cluster.firstTriangle;
+			if (cluster.nTriangles > 0)
+				clusters.push_back(cluster);
+			cluster.firstTriangle = (GLuint)order.size();
+		}
+
+		fanVertex = next;
+	}
+
+	std::vector<GLuint> cacheOrdered(nIndices);
+	for (GLuint t = 0; t < nTriangles; ++t)
+	{
+		cacheOrdered[t * 3] = indices[order[t] * 3];
+		cacheOrdered[t * 3 + 1] = indices[order[t] * 3 + 1];
+		cacheOrdered[t * 3 + 2] = indices[order[t] * 3 + 2];
+	}
+
+	// Overdraw: clusters facing away from the mesh center are the likely occluders, so they draw first
+	glm::vec3 meshCentroid;
+	glm::vec3 meshNormal;
+	UTriangleMoments(cacheOrdered.data(), 0, nTriangles, verts, meshCentroid, meshNormal);
+
+	for (TriangleCluster& c : clusters)
+	{
+		glm::vec3 centroid;
+		glm::vec3 normal;
+		UTriangleMoments(cacheOrdered.data(), c.firstTriangle, c.nTriangles, verts, centroid, normal);
+		GLfloat normalLength = glm::length(normal);
+		c.sortKey = normalLength > 0.0f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.0f;
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const TriangleCluster& a, const TriangleCluster& b)
+		{
+			return a.sortKey > b.sortKey;
+		});
+
+	GLuint* out = indices;
+	for (const TriangleCluster& c : clusters)
+	{
+		const GLuint* first = &cacheOrdered[c.firstTriangle * 3];
+		out = std::copy(first, first + c.nTriangles * 3, out);
+	}
+}
+
+
+void UOptimizeVertexFetch(GLfloat* verts, GLuint nVertices, GLuint* indices, GLuint nIndices)
+{
+	const GLuint unassigned = ~0u;
+	std::vector<GLuint> remap(nVertices, unassigned);
+	GLuint nextVertex = 0;
+
+	for (GLuint i = 0; i < nIndices; ++i)
+	{
+		GLuint& target = remap[indices[i]];
+		if (target == unassigned)
+			target = nextVertex++;
+		indices[i] = target;
+	}
+
+	// Unreferenced vertices keep their relative order after the referenced ones
+	for (GLuint v = 0; v < nVertices; ++v)
+	{
+		if (remap[v] == unassigned)
+			remap[v] = nextVertex++;
+	}
+
+	std::vector<GLfloat> reordered(nVertices * PRIMITIVE_FLOATS_PER_VERTEX);
+	for (GLuint v = 0; v < nVertices; ++v)
+	{
+		std::copy(verts + v * PRIMITIVE_FLOATS_PER_VERTEX, verts + (v + 1) * PRIMITIVE_FLOATS_PER_VERTEX,
+			&reordered[remap[v] * PRIMITIVE_FLOATS_PER_VERTEX]);
+	}
+	std::copy(reordered.begin(), reordered.end(), verts);
+}
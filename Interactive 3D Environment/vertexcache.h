@@ -0,0 +1,37 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+// Size of the simulated post-transform vertex cache (FIFO)
+const GLuint VERTEX_CACHE_SIZE = 16;
+
+// Post-transform cache efficiency of an index buffer
+struct VertexCacheStats
+{
+	GLfloat acmr;   // Average cache miss ratio: transformed vertices per triangle (0.5 is ideal)
+	GLfloat atvr;   // Average transform to vertex ratio: transformed vertices per used vertex (1.0 is ideal)
+};
+
+/* Simulates a FIFO post-transform cache over a triangle list.
+ * indices must be smaller than nVertices.
+ */
+VertexCacheStats UAnalyzeVertexCache(const GLuint* indices, GLuint nIndices, GLuint nVertices, GLuint cacheSize = VERTEX_CACHE_SIZE);
+
+/* Reorders the triangles of a list in place:
+ * first for vertex cache locality (Tipsify), then the resulting clusters are sorted
+ * so outward facing clusters draw first, which reduces overdraw from any view.
+ * verts are interleaved float vertices (position, normal, texture coords).
+ */
+void UOptimizeTriangleOrder(GLuint* indices, GLuint nIndices, const GLfloat* verts, GLuint nVertices, GLuint cacheSize = VERTEX_CACHE_SIZE);
+
+/* Reorders interleaved float vertices in the order the indices first reference them
+ * and remaps the indices, so vertex fetches walk the buffer linearly.
+ * Unreferenced vertices are moved to the end.
+ */
+void UOptimizeVertexFetch(GLfloat* verts, GLuint nVertices, GLuint* indices, GLuint nIndices);
@@ -0,0 +1,117 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "vertexformat.h"
+#include "primitives.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const GLfloat UNORM16_MAX = 65535.0f;
+	const GLfloat SNORM16_MAX = 32767.0f;
+
+	// Sign that treats 0 as positive so the octahedral fold is well defined
+	GLfloat USignNotZero(GLfloat value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+}
+
+
+void UEncodeOctahedral(const glm::vec3& normal, GLshort encoded[2])
+{
+	// Project onto the octahedron, then fold the lower hemisphere over the upper one
+	GLfloat sum = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+	GLfloat x = normal.x / sum;
+	GLfloat y = normal.y / sum;
+	if (normal.z < 0.0f)
+	{
+		GLfloat foldedX = (1.0f - std::fabs(y)) * USignNotZero(x);
+		GLfloat foldedY = (1.0f - std::fabs(x)) * USignNotZero(y);
+		x = foldedX;
+		y = foldedY;
+	}
+
+	encoded[0] = (GLshort)std::round(glm::clamp(x, -1.0f, 1.0f) * SNORM16_MAX);
+	encoded[1] = (GLshort)std::round(glm::clamp(y, -1.0f, 1.0f) * SNORM16_MAX);
+}
+
+
+// Mirrors octDecode() in the vertex shader
+glm::vec3 UDecodeOctahedral(const GLshort encoded[2])
+{
+	glm::vec3 v(encoded[0] / SNORM16_MAX, encoded[1] / SNORM16_MAX, 0.0f);
+	v.z = 1.0f - std::fabs(v.x) - std::fabs(v.y);
+	if (v.z < 0.0f)
+	{
+		GLfloat unfoldedX = (1.0f - std::fabs(v.y)) * USignNotZero(v.x);
+		GLfloat unfoldedY = (1.0f - std::fabs(v.x)) * USignNotZero(v.y);
+		v.x = unfoldedX;
+		v.y = unfoldedY;
+	}
+	return glm::normalize(v);
+}
+
+
+void UPackVertices(const GLfloat* verts, GLuint nVertices, PackedVertex* packed, glm::vec3& positionOffset, glm::vec3& positionScale, PackingError& error)
+{
+	error.position = 0.0f;
+	error.normalDegrees = 0.0f;
+	error.uv = 0.0f;
+
+	// Quantize relative to the mesh bounds for the best precision
+	glm::vec3 minimum(verts[0], verts[1], verts[2]);
+	glm::vec3 maximum = minimum;
+	for (GLuint i = 1; i < nVertices; ++i)
+	{
+		const GLfloat* v = verts + i * PRIMITIVE_FLOATS_PER_VERTEX;
+		minimum = glm::min(minimum, glm::vec3(v[0], v[1], v[2]));
+		maximum = glm::max(maximum, glm::vec3(v[0], v[1], v[2]));
+	}
+
+	positionOffset = minimum;
+	positionScale = maximum - minimum;
+	// Flat meshes (the plane) have no extent on one axis
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		if (positionScale[axis] == 0.0f)
+			positionScale[axis] = 1.0f;
+	}
+
+	for (GLuint i = 0; i < nVertices; ++i)
+	{
+		const GLfloat* v = verts + i * PRIMITIVE_FLOATS_PER_VERTEX;
+		PackedVertex& p = packed[i];
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			GLfloat normalized = (v[axis] - positionOffset[axis]) / positionScale[axis];
+			p.position[axis] = (GLushort)std::round(glm::clamp(normalized, 0.0f, 1.0f) * UNORM16_MAX);
+
+			GLfloat decoded = positionOffset[axis] + (p.position[axis] / UNORM16_MAX) * positionScale[axis];
+			error.position = std::max(error.position, std::fabs(decoded - v[axis]));
+		}
+		p.padding = 0;
+
+		glm::vec3 normal = glm::normalize(glm::vec3(v[3], v[4], v[5]));
+		UEncodeOctahedral(normal, p.normal);
+		// atan2 resolves the tiny angles acos rounds to 0 in floats
+		glm::vec3 decodedNormal = UDecodeOctahedral(p.normal);
+		GLfloat angle = std::atan2(glm::length(glm::cross(normal, decodedNormal)), glm::dot(normal, decodedNormal));
+		error.normalDegrees = std::max(error.normalDegrees, angle * 57.2957795f);
+
+		for (int axis = 0; axis < 2; ++axis)
+		{
+			p.uv[axis] = glm::packHalf1x16(v[6 + axis]);
+			error.uv = std::max(error.uv, std::fabs(glm::unpackHalf1x16(p.uv[axis]) - v[6 + axis]));
+		}
+	}
+}
+
@@ -0,0 +1,51 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+// Layouts the shared vertex buffer can be stored in
+enum VertexFormat
+{
+	VERTEX_FORMAT_FLOAT,    // 32 bytes: 8 floats (position, normal, texture coords)
+	VERTEX_FORMAT_PACKED    // 16 bytes: see PackedVertex
+};
+
+/* Compact vertex:
+ * positions are 16-bit normalized values relative to the bounds of their mesh,
+ * normals are octahedral encoded into two 16-bit signed normalized values,
+ * texture coords are half floats so tiled coords above 1 still fit
+ */
+struct PackedVertex
+{
+	GLushort position[3];
+	GLushort padding;       // Keeps the normal 4 byte aligned
+	GLshort normal[2];
+	GLushort uv[2];
+};
+
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must stay 16 bytes");
+
+// Largest reconstruction errors found while packing a mesh
+struct PackingError
+{
+	GLfloat position;       // In mesh units
+	GLfloat normalDegrees;  // Angle between the original and decoded normal
+	GLfloat uv;             // In texture coords
+};
+
+/* Packs interleaved float vertices (position, normal, texture coords).
+ * positionOffset and positionScale receive the dequantization the vertex shader applies:
+ * position = positionOffset + packedPosition * positionScale
+ */
+void UPackVertices(const GLfloat* verts, GLuint nVertices, PackedVertex* packed, glm::vec3& positionOffset, glm::vec3& positionScale, PackingError& error);
+
+// Octahedral normal encoding, also used to measure the packing error
+void UEncodeOctahedral(const glm::vec3& normal, GLshort encoded[2]);
+glm::vec3 UDecodeOctahedral(const GLshort encoded[2]);
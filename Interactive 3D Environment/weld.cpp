@@ -0,0 +1,88 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "weld.h"
+#include "primitives.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	// Quantized attributes of one vertex
+	struct WeldKey
+	{
+		int values[PRIMITIVE_FLOATS_PER_VERTEX];
+
+		bool operator==(const WeldKey& other) const
+		{
+			return std::memcmp(values, other.values, sizeof(values)) == 0;
+		}
+	};
+
+	// FNV-1a over the quantized values
+	struct WeldKeyHash
+	{
+		size_t operator()(const WeldKey& key) const
+		{
+			size_t hash = 2166136261u;
+			for (GLuint i = 0; i < PRIMITIVE_FLOATS_PER_VERTEX; ++i)
+			{
+				hash ^= (size_t)(unsigned int)key.values[i];
+				hash *= 16777619u;
+			}
+			return hash;
+		}
+	};
+
+	WeldKey UQuantize(const GLfloat* vertex)
+	{
+		// position (3), normal (3), texture coords (2)
+		const GLfloat steps[PRIMITIVE_FLOATS_PER_VERTEX] = {
+			WELD_POSITION_STEP, WELD_POSITION_STEP, WELD_POSITION_STEP,
+			WELD_NORMAL_STEP, WELD_NORMAL_STEP, WELD_NORMAL_STEP,
+			WELD_UV_STEP, WELD_UV_STEP
+		};
+
+		WeldKey key;
+		for (GLuint i = 0; i < PRIMITIVE_FLOATS_PER_VERTEX; ++i)
+			key.values[i] = (int)std::floor(vertex[i] / steps[i] + 0.5f);
+		return key;
+	}
+}
+
+
+GLuint UWeldVertices(GLfloat* verts, GLuint nVertices, GLuint* indices, GLuint nIndices)
+{
+	const GLuint unassigned = ~0u;
+	std::vector<GLuint> remap(nVertices, unassigned);
+	std::vector<GLfloat> welded;
+	welded.reserve(nVertices * PRIMITIVE_FLOATS_PER_VERTEX);
+	std::unordered_map<WeldKey, GLuint, WeldKeyHash> unique;
+	unique.reserve(nVertices);
+
+	// Survivors are numbered in the order the indices first reach them
+	for (GLuint i = 0; i < nIndices; ++i)
+	{
+		GLuint vertex = indices[i];
+		if (remap[vertex] == unassigned)
+		{
+			const GLfloat* attributes = verts + vertex * PRIMITIVE_FLOATS_PER_VERTEX;
+			GLuint next = (GLuint)(welded.size() / PRIMITIVE_FLOATS_PER_VERTEX);
+			std::pair<std::unordered_map<WeldKey, GLuint, WeldKeyHash>::iterator, bool> inserted = unique.insert(std::make_pair(UQuantize(attributes), next));
+			if (inserted.second)
+				welded.insert(welded.end(), attributes, attributes + PRIMITIVE_FLOATS_PER_VERTEX);
+			remap[vertex] = inserted.first->second;
+		}
+		indices[i] = remap[vertex];
+	}
+
+	std::copy(welded.begin(), welded.end(), verts);
+	return (GLuint)(welded.size() / PRIMITIVE_FLOATS_PER_VERTEX);
+}
@@ -0,0 +1,20 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+// Quantization steps below which two attributes count as identical
+const GLfloat WELD_POSITION_STEP = 1.0f / 8192.0f;
+const GLfloat WELD_NORMAL_STEP = 1.0f / 1024.0f;
+const GLfloat WELD_UV_STEP = 1.0f / 8192.0f;
+
+/* Merges interleaved vertices whose quantized position, normal and texture coords match,
+ * rewrites the indices to the survivors and compacts the vertices in place (first occurrence order).
+ * Vertices no index refers to are dropped. Returns the new number of vertices.
+ */
+GLuint UWeldVertices(GLfloat* verts, GLuint nVertices, GLuint* indices, GLuint nIndices);
@@ -0,0 +1,93 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#include "workerpool.h"
+
+#include <algorithm>
+
+void WorkerPool::CreateWorkerPool(GLuint nThreads)
+{
+	gThreads = std::max(1u, nThreads);
+	gJob = nullptr;
+	gJobs = 0;
+	gNextJob = 0;
+	gPending = 0;
+	gGeneration = 0;
+	gStopping = false;
+
+	for (GLuint t = 1; t < gThreads; ++t)
+		gWorkers.emplace_back(&WorkerPool::UWorkerLoop, this);
+}
+
+
+void WorkerPool::DestroyWorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(gMutex);
+		gStopping = true;
+	}
+	gStart.notify_all();
+
+	for (std::thread& worker : gWorkers)
+		worker.join();
+	gWorkers.clear();
+	gThreads = 1;
+}
+
+
+void WorkerPool::Run(GLuint nJobs, const std::function<void(GLuint)>& job)
+{
+	// Nothing to hand out, the calling thread does it all
+	if (gWorkers.empty() || nJobs < 2)
+	{
+		for (GLuint j = 0; j < nJobs; ++j)
+			job(j);
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(gMutex);
+	gJob = &job;
+	gJobs = nJobs;
+	gNextJob = 0;
+	gPending = nJobs;
+	++gGeneration;
+	gStart.notify_all();
+
+	UDoJobs(lock);
+	gDone.wait(lock, [this] { return gPending == 0; });
+	gJob = nullptr;
+}
+
+
+void WorkerPool::UDoJobs(std::unique_lock<std::mutex>& lock)
+{
+	while (gNextJob < gJobs)
+	{
+		GLuint j = gNextJob++;
+		lock.unlock();
+		(*gJob)(j);
+		lock.lock();
+
+		if (--gPending == 0)
+			gDone.notify_all();
+	}
+}
+
+
+void WorkerPool::UWorkerLoop()
+{
+	std::unique_lock<std::mutex> lock(gMutex);
+	GLuint seenGeneration = gGeneration;
+	while (true)
+	{
+		gStart.wait(lock, [&] { return gStopping || gGeneration != seenGeneration; });
+		if (gStopping)
+			return;
+
+		seenGeneration = gGeneration;
+		UDoJobs(lock);
+	}
+}
@@ -0,0 +1,50 @@
+/*------------------------------
+Author: Christian Henshaw
+Organization: SNHU
+Version: 1.0
+------------------------------*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Threads started once and reused by every Run, so per-frame work splits across cores
+ * without creating and joining threads each frame. The calling thread works too.
+ */
+class WorkerPool
+{
+public:
+	// Threads a Run can use, the calling thread included
+	GLuint gThreads;
+
+public:
+	// Starts nThreads - 1 workers
+	void CreateWorkerPool(GLuint nThreads);
+	// Stops and joins the workers
+	void DestroyWorkerPool();
+
+	// Calls job(0) to job(nJobs - 1) across the threads and returns once every call has finished
+	void Run(GLuint nJobs, const std::function<void(GLuint)>& job);
+
+private:
+	std::vector<std::thread> gWorkers;
+	std::mutex gMutex;
+	std::condition_variable gStart;     // Signals a new Run or shutdown to the workers
+	std::condition_variable gDone;      // Signals the last finished job to Run
+	const std::function<void(GLuint)>* gJob;
+	GLuint gJobs;
+	GLuint gNextJob;
+	GLuint gPending;                    // Jobs of the current Run not finished yet
+	GLuint gGeneration;                 // Counts Runs so a worker wakes once for each
+	bool gStopping;
+
+	// Takes jobs of the current Run until none are left
+	void UDoJobs(std::unique_lock<std::mutex>& lock);
+	void UWorkerLoop();
+};